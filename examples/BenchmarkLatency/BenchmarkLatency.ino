@@ -0,0 +1,83 @@
+// Sketch for measuring the tone start latency of the ArduboyTones library.
+//
+// Latency is measured from a tone() call to the first audio interrupt
+// after it, with the engine idle and with it already playing, and printed
+// to the serial monitor. For the edge and fixed rate engines that
+// interrupt writes the first edge or sample to the DAC. For the DMA
+// engine, when already playing, the new tone is rendered in that interrupt
+// and reaches the DAC after the other half of the buffer has played, so
+// add TONES_DMA_BUFFER_SIZE / 2 samples.
+//
+// The interrupts are counted by the library's statistics, so TONES_STATS
+// must be defined as 1 in the build flags, along with TONES_ENGINE to
+// select the engine.
+
+#include <ArduboyTones.h>
+
+ArduboyTones sound(NULL); // no mute function, so sound is always on
+
+#define LATENCY_RUNS 100
+
+#if TONES_STATS
+// Time from a tone() call to the next audio interrupt, with the engine
+// either idle or already playing
+void runLatency(const char *name, bool whilePlaying) {
+  uint32_t begin;
+  uint32_t interrupts;
+  uint32_t cycles;
+  uint32_t total = 0;
+  uint32_t worst = 0;
+  unsigned long start;
+
+  for (int i = 0; i < LATENCY_RUNS; i++) {
+    if (whilePlaying) {
+      sound.tone(NOTE_C4, 0);
+    }
+    else {
+      sound.noTone();
+    }
+    delay(20); // let the engine settle or stop
+
+    interrupts = sound.stats().interrupts;
+    begin = DWT->CYCCNT;
+    sound.tone(NOTE_A5, 0);
+
+    start = millis();
+    while (sound.stats().interrupts == interrupts && millis() - start < 100);
+    cycles = DWT->CYCCNT - begin;
+
+    total += cycles;
+    if (cycles > worst) {
+      worst = cycles;
+    }
+  }
+  sound.noTone();
+
+  Serial.print("latency ");
+  Serial.print(name);
+  Serial.print(", avg us ");
+  Serial.print((double)total / LATENCY_RUNS / (F_CPU / 1000000), 1);
+  Serial.print(", max us ");
+  Serial.println((double)worst / (F_CPU / 1000000), 1);
+}
+#endif
+
+void setup() {
+  Serial.begin(9600);
+  while (!Serial);
+
+  Serial.print("ArduboyTones latency benchmark, TONES_ENGINE ");
+  Serial.println(TONES_ENGINE);
+
+#if TONES_STATS
+  runLatency("idle", false);
+  runLatency("playing", true);
+#else
+  Serial.println("Define TONES_STATS as 1 to measure latency");
+#endif
+
+  Serial.println("done");
+}
+
+void loop() {
+}
@@ -0,0 +1,139 @@
+// Sketch for benchmarking the CPU load of the ArduboyTones library.
+//
+// Results are printed to the serial monitor, one line per test, so they can
+// be saved and compared between releases and between playback engines.
+// Select the engine by defining TONES_ENGINE in the build flags. The
+// BenchmarkLatency and BenchmarkTuning sketches measure the rest.
+//
+// For the interrupt columns, also define TONES_STATS as 1. Without it only
+// loop() iterations are measured.
+//
+// Tests:
+//   baseline  Nothing playing. Loop rate with no audio overhead.
+//   octave N  The 12 notes of octave N, playing repeatedly.
+//   B9        NOTE_B9 sustained, the worst case for the edge engine.
+//   retrigger tone() restarted every RETRIGGER_US microseconds.
+//   repeat    A TONES_REPEAT sequence of very short notes, so mostly
+//             note transitions.
+//
+// Columns:
+//   loops/s   loop iterations per second, and as a percentage of baseline
+//   int/s     audio interrupts per second
+//   isr%      share of the CPU spent in the audio interrupt
+//   maxcyc    longest single audio interrupt, in CPU cycles
+//   trans/s   note transitions per second
+
+#include <ArduboyTones.h>
+
+ArduboyTones sound(NULL); // no mute function, so sound is always on
+
+#define TEST_MS 2000
+#define RETRIGGER_US 1000
+
+#define NDUR 50
+// Every NOTE_* value, C0 to B9, from the library's own list of notes
+#define NOTE_HZ(n) NOTE_##n,
+const uint16_t noteList[] PROGMEM = { TONES_NOTE_LIST(NOTE_HZ) };
+
+const uint16_t shortNotes[] PROGMEM = {
+  NOTE_C5,2, NOTE_E5,2, NOTE_G5,2, NOTE_C6,2, NOTE_REST,2,
+  NOTE_G5,2, NOTE_E5,2, NOTE_C5,2, NOTE_G4,2, NOTE_REST,2,
+  TONES_REPEAT
+};
+
+uint16_t octave[12 * 2 + 1];
+
+unsigned long baseline = 0;
+
+// Run the foreground loop for TEST_MS and print the results
+void runTest(const char *name, int num, bool retrigger) {
+  unsigned long start;
+  unsigned long lastTrigger;
+  unsigned long loops = 0;
+  unsigned long rate;
+
+#if TONES_STATS
+  sound.stats(true);
+#endif
+  lastTrigger = micros();
+  start = millis();
+
+  while (millis() - start < TEST_MS) {
+    loops++;
+    if (retrigger && micros() - lastTrigger >= RETRIGGER_US) {
+      lastTrigger = micros();
+      sound.tone(NOTE_A5, 50);
+    }
+  }
+
+#if TONES_STATS
+  TonesStats s = sound.stats();
+#endif
+  rate = loops * 1000 / TEST_MS;
+  if (baseline == 0) {
+    baseline = rate;
+  }
+
+  Serial.print(name);
+  if (num >= 0) {
+    Serial.print(" ");
+    Serial.print(num);
+  }
+  Serial.print(", loops/s ");
+  Serial.print(rate);
+  Serial.print(" (");
+  Serial.print((unsigned long)((unsigned long long)rate * 100 / baseline));
+  Serial.print("%)");
+#if TONES_STATS
+  Serial.print(", int/s ");
+  Serial.print(s.interruptsPerSecond);
+  Serial.print(", isr% ");
+  Serial.print((double)s.isrCycles * 100 / ((double)F_CPU / 1000 * s.elapsedMs), 2);
+  Serial.print(", maxcyc ");
+  Serial.print(s.isrMaxCycles);
+  Serial.print(", trans/s ");
+  Serial.print(s.transitions * 1000 / s.elapsedMs);
+#endif
+  Serial.println();
+}
+
+void setup() {
+  Serial.begin(9600);
+  while (!Serial);
+
+  Serial.print("ArduboyTones load benchmark, TONES_ENGINE ");
+  Serial.print(TONES_ENGINE);
+  Serial.print(", TONES_CHANNELS ");
+  Serial.print(TONES_CHANNELS);
+  Serial.print(", TONES_STATS ");
+  Serial.println(TONES_STATS);
+
+  runTest("baseline", -1, false);
+
+  for (int o = 0; o < 10; o++) {
+    for (int i = 0; i < 12; i++) {
+      octave[i * 2] = pgm_read_word(noteList + o * 12 + i);
+      octave[i * 2 + 1] = NDUR;
+    }
+    octave[12 * 2] = TONES_REPEAT;
+    sound.tonesInRAM(octave);
+    runTest("octave", o, false);
+    sound.noTone();
+  }
+
+  sound.tone(NOTE_B9, 0);
+  runTest("B9", -1, false);
+  sound.noTone();
+
+  runTest("retrigger", -1, true);
+  sound.noTone();
+
+  sound.tones(shortNotes);
+  runTest("repeat", -1, false);
+  sound.noTone();
+
+  Serial.println("done");
+}
+
+void loop() {
+}
@@ -0,0 +1,66 @@
+// Sketch for checking the tuning of the ArduboyTones library.
+//
+// For each octave it prints the worst tuning error of its 12 notes to the
+// serial monitor, in cents, against equal temperament from A4 = 440 Hz.
+// The frequencies come from tunedFrequency(), the average the selected
+// engine actually plays, so nothing needs to be listened to or measured.
+// Select the engine by defining TONES_ENGINE in the build flags.
+//
+//   tuning N  The worst tuning error of the notes of octave N. "whole Hz"
+//             is for the NOTE_* values played by tone(), "fine" for the
+//             exact NOTE_FINE_* values played by toneFine() and for
+//             noteTones().
+
+#include <ArduboyTones.h>
+#include <math.h>
+
+ArduboyTones sound(NULL); // no mute function, so sound is always on
+
+// Every NOTE_* value, C0 to B9, from the library's own list of notes
+#define NOTE_HZ(n) NOTE_##n,
+const uint16_t noteList[] PROGMEM = { TONES_NOTE_LIST(NOTE_HZ) };
+
+// The error of a frequency from tunedFrequency(), in cents
+double centsOff(uint32_t played, double exact) {
+  return fabs(1200.0 * log(played / 16.0 / exact) / log(2.0));
+}
+
+void setup() {
+  Serial.begin(9600);
+  while (!Serial);
+
+  Serial.print("ArduboyTones tuning, TONES_ENGINE ");
+  Serial.println(TONES_ENGINE);
+
+  for (int o = 0; o < 10; o++) {
+    double worstWhole = 0;
+    double worstFine = 0;
+    double exact;
+    double c;
+
+    for (int i = 0; i < 12; i++) {
+      exact = 440.0 * pow(2.0, (o * 12 + i - 57) / 12.0);
+      c = centsOff(sound.tunedFrequency(
+                     pgm_read_word(noteList + o * 12 + i) * 16UL), exact);
+      if (c > worstWhole) {
+        worstWhole = c;
+      }
+      c = centsOff(sound.tunedFrequency(TONES_FINE_HZ(exact)), exact);
+      if (c > worstFine) {
+        worstFine = c;
+      }
+    }
+
+    Serial.print("tuning ");
+    Serial.print(o);
+    Serial.print(", whole Hz cents ");
+    Serial.print(worstWhole, 3);
+    Serial.print(", fine cents ");
+    Serial.println(worstFine, 3);
+  }
+
+  Serial.println("done");
+}
+
+void loop() {
+}
@@ -0,0 +1,77 @@
+// Sketch for measuring the idle cost of the ArduboyTones library.
+//
+// Build it once normally and once with TONES_POWER_SAVE=1 (and optionally
+// TONES_DAC_POWER_DOWN=1) in the build flags, then compare the results.
+//
+// The sketch cycles through three phases of a few seconds each: playing a
+// tone, playing a long rest, and idle after the sound has ended. For each
+// phase it prints the number of loop() iterations per second to the serial
+// monitor. Time spent in the audio interrupt is taken from loop(), so a
+// higher count means less CPU used by the library. With TONES_POWER_SAVE
+// the rest and idle counts should match a sketch without sound.
+//
+// To see the power difference, measure the supply current with a meter
+// during each phase. The serial output shows which phase is running.
+
+#include <ArduboyTones.h>
+
+ArduboyTones sound(NULL); // no mute function, so sound is always on
+
+#define PHASE_MS 3000
+
+const uint16_t longRest[] PROGMEM = {
+  NOTE_REST,PHASE_MS,
+  TONES_END
+};
+
+const char *phaseNames[] = { "tone", "rest", "idle" };
+
+uint8_t phase = 0;
+unsigned long phaseStart;
+unsigned long loops;
+
+void startPhase() {
+  if (phase == 0) {
+    sound.tone(NOTE_A4, PHASE_MS);
+  }
+  else if (phase == 1) {
+    sound.tones(longRest);
+  }
+  // nothing is started for the idle phase
+
+  loops = 0;
+  phaseStart = millis();
+}
+
+void setup() {
+  Serial.begin(9600);
+  while (!Serial);
+
+  Serial.print("TONES_ENGINE ");
+  Serial.print(TONES_ENGINE);
+  Serial.print(", TONES_POWER_SAVE ");
+  Serial.print(TONES_POWER_SAVE);
+  Serial.print(", TONES_DAC_POWER_DOWN ");
+  Serial.println(TONES_DAC_POWER_DOWN);
+
+  startPhase();
+}
+
+void loop() {
+  unsigned long elapsed;
+
+  loops++;
+
+  elapsed = millis() - phaseStart;
+  if (elapsed < PHASE_MS) {
+    return;
+  }
+
+  Serial.print(phaseNames[phase]);
+  Serial.print(": ");
+  Serial.print(loops * 1000 / elapsed);
+  Serial.println(" loops/s");
+
+  phase = (phase + 1) % 3;
+  startPhase();
+}
@@ -0,0 +1,38 @@
+/**
+ * @file Arduino.h
+ * \brief The parts of the Arduino API used by ArduboyTones, for building
+ * it on a desktop computer with TONES_HOST defined as 1.
+ *
+ * Only for offline rendering with tones2wav.cpp. Nothing here touches
+ * hardware. Program memory is ordinary memory and the interrupt controller
+ * calls do nothing, since nothing runs in an interrupt.
+ */
+
+#ifndef TONES_HOST_ARDUINO_H
+#define TONES_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// The Wio Terminal's CPU clock, which the sample timer counts are based on
+#ifndef F_CPU
+#define F_CPU 120000000UL
+#endif
+
+typedef bool boolean;
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+
+#define PIN_DAC1 1
+
+static inline void NVIC_DisableIRQ(int irq) { (void)irq; }
+static inline void NVIC_EnableIRQ(int irq) { (void)irq; }
+
+static inline uint32_t __get_PRIMASK() { return 0; }
+static inline void __set_PRIMASK(uint32_t mask) { (void)mask; }
+static inline void __disable_irq() { }
+
+#endif
@@ -0,0 +1,257 @@
+// Render an ArduboyTones sequence to a WAV file on a desktop computer, and
+// check its timing.
+//
+// The library is built with TONES_HOST defined as 1, which compiles the
+// fixed rate engine's sequencing and synthesis without any hardware access.
+// Samples are pulled with fillBuffer(), so a sequence renders many times
+// faster than real time and exactly as the Wio Terminal would play it with
+// TONES_ENGINE_FIXED_RATE. That's the only engine built or rendered here;
+// TONES_ENGINE_DMA and the edge engine need the Wio Terminal's timers.
+//
+// Build with "make -C extras/host", or from the repository root, adding any
+// other TONES_ flags to try:
+//
+//   g++ -O2 -std=gnu++11 -DTONES_HOST=1 -DTONES_ENGINE=2
+//     -Iextras/host -Isrc extras/host/tones2wav.cpp src/ArduboyTones.cpp
+//     -o tones2wav
+//
+// Then render a sequence stored in the tonesStream() format, 16 bit little
+// endian frequency/duration words:
+//
+//   ./tones2wav song.bin song.wav [maxSeconds]
+//
+// Or compile a sketch's tones() array into the program by also adding
+// -DSONG_FILE='"mysong.h"' -DSONG=mySong, and run:
+//
+//   ./tones2wav song.wav [maxSeconds]
+//
+// The report gives the length of the sequence from its durations, where it
+// actually ended, and the difference. It should be less than one sample,
+// plus, with TONES_DURATION_MS, a drift of some tens of ppm if the sample
+// rate isn't a multiple of 125, since a millisecond is then not a whole
+// number of 1024ths of a sample. A sequence that repeats or has an infinite tone
+// is rendered for maxSeconds (10 by default).
+//
+// The exit status is 0 if the end is within that tolerance, 3 if it isn't,
+// so a script can check for timing regressions, and 1 or 2 for file or
+// usage errors. A sequence stopped by maxSeconds before its end isn't
+// checked.
+
+#include <ArduboyTones.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+
+#ifdef SONG_FILE
+#include SONG_FILE
+#endif
+
+#if TONES_DURATION_MS
+#define DURATION_UNITS 1000
+// Samples per millisecond are counted in 1024ths, rounded down, so a
+// sequence can end up to this fraction of its length early
+#define DURATION_DRIFT (1.0 / (TONES_SAMPLE_RATE * 1024 / 1000))
+#else
+#define DURATION_UNITS 1024
+#define DURATION_DRIFT 0.0
+#endif
+
+static bool alwaysOn()
+{
+  return true;
+}
+
+ArduboyTones sound(alwaysOn);
+
+// The total duration of a sequence, or 0 if it never ends
+static uint64_t sequenceUnits(const uint16_t *tones)
+{
+  uint64_t length = 0;
+
+  while (true) {
+    if (*tones == TONES_END) {
+      return length;
+    }
+    if (*tones >= TONES_FX_FIRST) { // an effect command, not a tone
+      tones += 2;
+      continue;
+    }
+    if (*tones == TONES_REPEAT || tones[1] == 0) {
+      return 0;
+    }
+    length += tones[1];
+    tones += 2;
+  }
+}
+
+static void put16(FILE *f, uint16_t v)
+{
+  fputc(v & 0xFF, f);
+  fputc(v >> 8, f);
+}
+
+static void put32(FILE *f, uint32_t v)
+{
+  put16(f, v & 0xFFFF);
+  put16(f, v >> 16);
+}
+
+// Write 16 bit mono PCM. The DAC's 12 bit levels are centred on 0.
+static bool writeWav(const char *name, const std::vector<uint16_t> &samples)
+{
+  FILE *f = fopen(name, "wb");
+  uint32_t bytes = samples.size() * 2;
+
+  if (f == NULL) {
+    return false;
+  }
+
+  fputs("RIFF", f);
+  put32(f, 36 + bytes);
+  fputs("WAVEfmt ", f);
+  put32(f, 16);
+  put16(f, 1); // PCM
+  put16(f, 1); // mono
+  put32(f, TONES_SAMPLE_RATE);
+  put32(f, TONES_SAMPLE_RATE * 2);
+  put16(f, 2);
+  put16(f, 16);
+  fputs("data", f);
+  put32(f, bytes);
+
+  for (size_t i = 0; i < samples.size(); i++) {
+    put16(f, (uint16_t)((int32_t)samples[i] * 16 - 32768));
+  }
+
+  return fclose(f) == 0;
+}
+
+#ifndef SONG
+// Read a sequence in the tonesStream() format, adding a TONES_END if it
+// doesn't end with a marker
+static bool readSequence(const char *name, std::vector<uint16_t> &tones)
+{
+  FILE *f = fopen(name, "rb");
+  int lo;
+  int hi;
+
+  if (f == NULL) {
+    return false;
+  }
+
+  while ((lo = fgetc(f)) != EOF && (hi = fgetc(f)) != EOF) {
+    tones.push_back(lo | (hi << 8));
+  }
+  fclose(f);
+
+  for (size_t i = 0; i < tones.size(); i += 2) {
+    if (tones[i] == TONES_END || tones[i] == TONES_REPEAT) {
+      tones.resize(i + 1);
+      return true;
+    }
+  }
+
+  if (tones.size() & 1) {
+    tones.pop_back(); // a frequency without its duration
+  }
+  tones.push_back(TONES_END);
+  return true;
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+  std::vector<uint16_t> tones;
+  std::vector<uint16_t> samples;
+  const char *wavName;
+  const char *maxArg;
+  uint64_t units;
+  uint64_t maxSamples;
+  uint16_t sample;
+  clock_t begin;
+  double seconds;
+
+#ifdef SONG
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s out.wav [maxSeconds]\n", argv[0]);
+    return 2;
+  }
+  wavName = argv[1];
+  maxArg = (argc > 2) ? argv[2] : NULL;
+  for (const uint16_t *t = SONG; ; t += 2) {
+    tones.push_back(t[0]);
+    if (t[0] == TONES_END || t[0] == TONES_REPEAT) {
+      break;
+    }
+    tones.push_back(t[1]);
+  }
+#else
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s in.bin out.wav [maxSeconds]\n", argv[0]);
+    return 2;
+  }
+  if (!readSequence(argv[1], tones)) {
+    fprintf(stderr, "can't read %s\n", argv[1]);
+    return 1;
+  }
+  wavName = argv[2];
+  maxArg = (argc > 3) ? argv[3] : NULL;
+#endif
+
+  maxSamples = (uint64_t)((maxArg != NULL ? atof(maxArg) : 10.0) *
+                          TONES_SAMPLE_RATE);
+  units = sequenceUnits(tones.data());
+
+  sound.tonesInRAM(tones.data());
+
+  begin = clock();
+  while (samples.size() < maxSamples) {
+    ArduboyTones::fillBuffer(&sample, 1);
+    if (!sound.playing()) {
+      break; // this sample found the end, so follows the last tone
+    }
+    samples.push_back(sample);
+  }
+  seconds = (double)(clock() - begin) / CLOCKS_PER_SEC;
+
+  if (!writeWav(wavName, samples)) {
+    fprintf(stderr, "can't write %s\n", wavName);
+    return 1;
+  }
+
+  printf("engine %d, channels %d, sample rate %d\n",
+         TONES_ENGINE, TONES_CHANNELS, TONES_SAMPLE_RATE);
+  printf("rendered %lu samples (%.3f s)", (unsigned long)samples.size(),
+         (double)samples.size() / TONES_SAMPLE_RATE);
+  if (seconds > 0) {
+    printf(", %.0fx real time", samples.size() / (seconds * TONES_SAMPLE_RATE));
+  }
+  printf("\n");
+
+  if (units != 0 && samples.size() >= maxSamples) {
+    printf("sequence still playing, stopped after %.0f s\n",
+           (double)maxSamples / TONES_SAMPLE_RATE);
+  }
+  else if (units != 0) {
+    double expected = (double)units * TONES_SAMPLE_RATE / DURATION_UNITS;
+    double error = (samples.size() > expected) ? samples.size() - expected :
+                                                 expected - samples.size();
+    double allowed = 1.0 + expected * DURATION_DRIFT;
+
+    printf("sequence length %lu units, %.2f samples, ended %.2f samples %s\n",
+           (unsigned long)units, expected, error,
+           (samples.size() >= expected) ? "late" : "early");
+    if (error >= allowed) {
+      printf("timing error over the %.2f samples allowed\n", allowed);
+      return 3;
+    }
+  }
+  else {
+    printf("sequence never ends, stopped after %.0f s\n",
+           (double)maxSamples / TONES_SAMPLE_RATE);
+  }
+
+  return 0;
+}
@@ -0,0 +1,227 @@
+// Timing tests for ArduboyTones, run on a desktop computer.
+//
+// Each test starts a sequence, renders it with fillBuffer() until it stops
+// playing, and checks that it lasted as long as its durations add up to.
+// The allowed error is less than one sample, plus, with TONES_DURATION_MS,
+// the drift described in tones2wav.cpp. The program prints a line for each
+// test and exits with status 1 if any failed, so it can be run from make or
+// a script. Build it with the Makefile in this directory:
+//
+//   make -C extras/host test
+//
+// which builds and runs it for several configurations. The tests that need
+// more than one channel, note effects or samples only run when the library
+// is built with them.
+
+#include <ArduboyTones.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if TONES_DURATION_MS
+#define DURATION_UNITS 1000
+#define DURATION_DRIFT (1.0 / (TONES_SAMPLE_RATE * 1024 / 1000))
+#else
+#define DURATION_UNITS 1024
+#define DURATION_DRIFT 0.0
+#endif
+
+// Longer than any test, so a sequence that never ends fails instead of
+// hanging
+#define MAX_SAMPLES (TONES_SAMPLE_RATE * 20UL)
+
+static bool alwaysOn()
+{
+  return true;
+}
+
+ArduboyTones sound(alwaysOn);
+
+static int failures = 0;
+
+// Render until nothing is playing, returning the number of samples played
+static uint32_t render()
+{
+  uint32_t count = 0;
+  uint16_t sample;
+
+  while (count < MAX_SAMPLES) {
+    ArduboyTones::fillBuffer(&sample, 1);
+    if (!sound.playing()
+#if TONES_PCM
+        && !sound.samplePlaying()
+#endif
+       ) {
+      break;
+    }
+    count++;
+  }
+  return count;
+}
+
+// Record the result of a test that isn't a length
+static void checkTrue(const char *name, bool pass)
+{
+  printf("%s %s\n", pass ? "ok  " : "FAIL", name);
+  if (!pass) {
+    failures++;
+  }
+}
+
+// Check a rendered length against the expected number of samples
+static void checkSamples(const char *name, uint32_t samples, double expected)
+{
+  double error = (samples > expected) ? samples - expected :
+                                        expected - samples;
+  double allowed = 1.0 + expected * DURATION_DRIFT;
+  bool pass = (error < allowed);
+
+  printf("%s %s: %lu samples, expected %.2f\n", pass ? "ok  " : "FAIL",
+         name, (unsigned long)samples, expected);
+  if (!pass) {
+    failures++;
+  }
+}
+
+// Check a rendered length against a length in duration units
+static void check(const char *name, uint32_t samples, uint32_t units)
+{
+  checkSamples(name, samples,
+               (double)units * TONES_SAMPLE_RATE / DURATION_UNITS);
+}
+
+const uint16_t song[] PROGMEM = {
+  440,100, 0,50, 660,200, TONES_END
+};
+
+const uint16_t chained[] PROGMEM = {
+  880,150, TONES_END
+};
+
+const uint16_t notes[] PROGMEM = {
+  NOTE_INDEX_C4,120, NOTE_INDEX_REST,30, NOTE_INDEX_E4,90, TONES_END
+};
+
+const uint8_t packed[] PROGMEM = {
+  2, TONES_PACKED_DURATION(125), TONES_PACKED_DURATION(250),
+  TONES_PACKED_NOTE(NOTE_INDEX_C4, 0),
+  TONES_PACKED_NOTE(NOTE_INDEX_E4 + TONES_PACKED_HIGH_VOLUME, 1),
+  TONES_PACKED_RUN(NOTE_INDEX_REST, 0, 3),
+  TONES_PACKED_END
+};
+
+const uint16_t bar[] PROGMEM = { 440,100, 550,100, TONES_END };
+const uint16_t fill[] PROGMEM = { 330,300, TONES_END };
+const uint16_t * const patterns[] = { bar, fill };
+
+const uint8_t order[] PROGMEM = {
+  0, 1, 0, TONES_ORDER_END, // channel 0, 700 units
+#if TONES_CHANNELS > 1
+  1, 1, TONES_ORDER_END     // channel 1, 600 units
+#endif
+};
+
+const uint16_t blip[] PROGMEM = { 1200,40, 900,60, TONES_END };
+const uint16_t * const sfx[] = { song, blip };
+
+const uint16_t cued[] PROGMEM = {
+  440,100, TONES_CUE(3), 550,100, TONES_END
+};
+
+#if TONES_NOTE_EFFECTS
+const uint16_t effects[] PROGMEM = {
+  TONES_VIBRATO(50, 6), 440,200,
+  TONES_SWEEP(12), 220,150,
+  TONES_ARPEGGIO(4, 7, 30), 330,100,
+  TONES_CUE(7), 0,50,
+  TONES_END
+};
+#endif
+
+#if TONES_PCM
+static uint8_t pcm[4000];
+#endif
+
+int main()
+{
+  printf("engine %d, channels %d, sample rate %d, duration ms %d\n",
+         TONES_ENGINE, TONES_CHANNELS, TONES_SAMPLE_RATE, TONES_DURATION_MS);
+
+  sound.tone(440, 250);
+  check("tone", render(), 250);
+
+  sound.tone(440, 100, 550, 100, 660, 100);
+  check("tone x3", render(), 300);
+
+#if MAX_TONES >= 5
+  sound.tone(440, 100, 550, 100, 660, 100, 770, 100, 880, 100);
+  check("tone x5", render(), 500);
+
+  // The same request buffer again, now holding a longer sequence
+  sound.tone(440, 100, 550, 100, 660, 100);
+  check("tone x3 after x5", render(), 300);
+#endif
+
+  sound.tone<NOTE_C5, 80, NOTE_E5, 80, NOTE_G5, 240>();
+  check("tone<>", render(), 400);
+
+  sound.tones(song);
+  check("tones", render(), 350);
+
+  sound.tones(song);
+  sound.tonesNext(chained);
+  check("tonesNext", render(), 500);
+
+  sound.noteTones(notes);
+  check("noteTones", render(), 240);
+
+  sound.tonesPacked(packed);
+  check("tonesPacked", render(), 125 + 250 + 3 * 125);
+
+  sound.tonesPatterns(patterns, order, TONES_CHANNELS > 1 ? 2 : 1);
+  check("tonesPatterns", render(), 700);
+
+  sound.setEffects(sfx, 2);
+  sound.trigger(1);
+  check("trigger", render(), 100);
+
+  sound.noTone();
+  sound.tones(song);
+  check("noTone then tones", render(), 350);
+
+#if TONES_CUE_QUEUE_SIZE > 0
+  TonesCue cue;
+
+  // None of the sequences so far had cue markers, so none queued an end
+  checkTrue("no cues from plain sequences", !sound.readCue(cue));
+
+  sound.tones(cued);
+  check("cue marker", render(), 200);
+  checkTrue("cue event", sound.readCue(cue) && cue.id == 3);
+  checkTrue("cue end event", sound.readCue(cue) && cue.id == TONES_CUE_END);
+  checkTrue("cue queue empty", !sound.readCue(cue));
+#endif
+
+#if TONES_NOTE_EFFECTS
+  sound.tones(effects);
+  check("note effects", render(), 500);
+#endif
+
+#if TONES_PCM
+  for (uint16_t i = 0; i < sizeof(pcm); i++) {
+    pcm[i] = (i & 16) ? 200 : 56;
+  }
+  // The 16.16 step is rounded down, so the sample plays very slightly long
+  uint32_t step = (8000UL << 16) / TONES_SAMPLE_RATE;
+  sound.playSample(pcm, sizeof(pcm), 8000);
+  checkSamples("playSample", render(),
+               (double)sizeof(pcm) * 65536 / step);
+#endif
+
+  if (failures != 0) {
+    printf("%d failed\n", failures);
+    return 1;
+  }
+  printf("all passed\n");
+  return 0;
+}
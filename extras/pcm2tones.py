@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+# Converts a WAV file to sample data for playSample().
+#
+# Run with the WAV file and a name for the data:
+#   python3 extras/pcm2tones.py boom.wav boom > boom.h
+#   python3 extras/pcm2tones.py --adpcm --rate 8000 voice.wav voice > voice.h
+#
+# The output defines the data array, and <NAME>_LENGTH and <NAME>_RATE to
+# pass to playSample() along with it. Stereo files are mixed to mono. With
+# --rate the sound is resampled, which is worth doing since the data's size
+# is proportional to its rate. 8 kHz is usually enough for effects.
+#
+# With --adpcm the data is 4 bit IMA ADPCM, taking half the space of 8 bit
+# PCM. It's encoded starting from a level of 0 and a step index of 0, as
+# playSample() decodes it.
+
+import argparse
+import struct
+import wave
+
+ADPCM_STEPS = [
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41,
+    45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190,
+    209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499,
+    2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845,
+    8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350,
+    22385, 24623, 27086, 29794, 32767]
+ADPCM_INDEX_CHANGE = [-1, -1, -1, -1, 2, 4, 6, 8]
+
+
+def read_wav(name):
+    # Returns the samples as 16 bit signed values, mixed to mono, and the
+    # sample rate
+    with wave.open(name, 'rb') as w:
+        channels = w.getnchannels()
+        width = w.getsampwidth()
+        rate = w.getframerate()
+        frames = w.readframes(w.getnframes())
+
+    if width == 1:
+        values = [(b - 128) << 8 for b in frames]
+    elif width == 2:
+        values = list(struct.unpack('<%dh' % (len(frames) // 2), frames))
+    else:
+        raise SystemExit('only 8 and 16 bit WAV files are supported')
+
+    mono = []
+    for i in range(0, len(values) - channels + 1, channels):
+        mono.append(sum(values[i:i + channels]) // channels)
+    return mono, rate
+
+
+def resample(samples, rate, new_rate):
+    # Linear interpolation, which is fine for reducing an effect's rate
+    out = []
+    step = rate / new_rate
+    pos = 0.0
+    while pos < len(samples) - 1:
+        i = int(pos)
+        frac = pos - i
+        out.append(int(samples[i] * (1 - frac) + samples[i + 1] * frac))
+        pos += step
+    return out
+
+
+def encode_adpcm(samples):
+    predictor = 0
+    index = 0
+    codes = []
+
+    for s in samples:
+        step = ADPCM_STEPS[index]
+        diff = s - predictor
+        code = 0
+        if diff < 0:
+            code = 8
+            diff = -diff
+
+        # The same arithmetic as the decoder, so it tracks the decoded level
+        delta = step >> 3
+        if diff >= step:
+            code |= 4
+            diff -= step
+            delta += step
+        if diff >= step >> 1:
+            code |= 2
+            diff -= step >> 1
+            delta += step >> 1
+        if diff >= step >> 2:
+            code |= 1
+            delta += step >> 2
+
+        predictor += -delta if code & 8 else delta
+        predictor = max(-32768, min(32767, predictor))
+        index = max(0, min(88, index + ADPCM_INDEX_CHANGE[code & 7]))
+        codes.append(code)
+
+    if len(codes) & 1:
+        codes.append(0)
+    return [codes[i] | (codes[i + 1] << 4) for i in range(0, len(codes), 2)]
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Convert a WAV file to playSample() data')
+    parser.add_argument('wav')
+    parser.add_argument('name')
+    parser.add_argument('--rate', type=int, help='resample to this rate')
+    parser.add_argument('--adpcm', action='store_true',
+                        help='encode as 4 bit IMA ADPCM')
+    args = parser.parse_args()
+
+    samples, rate = read_wav(args.wav)
+    if args.rate and args.rate != rate:
+        samples = resample(samples, rate, args.rate)
+        rate = args.rate
+
+    if args.adpcm:
+        data = encode_adpcm(samples)
+    else:
+        data = [(s >> 8) + 128 for s in samples]
+
+    name = args.name
+    print('// Generated by extras/pcm2tones.py from %s' % args.wav)
+    print('// Play with: sound.playSample(%s, %s_LENGTH, %s_RATE%s);' %
+          (name, name.upper(), name.upper(),
+           ', TONES_PCM_ADPCM' if args.adpcm else ''))
+    print()
+    print('#define %s_LENGTH %d' % (name.upper(), len(samples)))
+    print('#define %s_RATE %d' % (name.upper(), rate))
+    print()
+    print('const uint8_t %s[] PROGMEM = {' % name)
+    for i in range(0, len(data), 16):
+        print('  ' + ', '.join('0x%02X' % b for b in data[i:i + 16]) + ',')
+    print('};')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+# Generates src/ArduboyTonesWaves.h, the wavetables used by setWaveform().
+#
+# Run from the repository root:
+#   python3 extras/wavetables.py > src/ArduboyTonesWaves.h
+
+import math
+
+SIZE = 256
+LEVELS = 6  # band limited tables with up to 1, 3, 7, 15, 31, 63 harmonics
+
+
+def normalize(values):
+    lo = min(values)
+    hi = max(values)
+    return [round((v - lo) * 255 / (hi - lo)) for v in values]
+
+
+def additive(max_harmonic, odd_only):
+    values = []
+    for i in range(SIZE):
+        x = i / SIZE
+        v = 0.0
+        for n in range(1, max_harmonic + 1):
+            if odd_only and n % 2 == 0:
+                continue
+            v += math.sin(2 * math.pi * n * x) / n
+        values.append(v)
+    return normalize(values)
+
+
+def triangle():
+    values = []
+    for i in range(SIZE):
+        x = (i / SIZE + 0.25) % 1.0
+        values.append(1 - 4 * abs(x - 0.5))
+    return normalize(values)
+
+
+def emit(name, tables, comment):
+    print("// " + comment)
+    if len(tables) == 1:
+        print("static const uint8_t %s[%d] PROGMEM = {" % (name, SIZE))
+    else:
+        print("static const uint8_t %s[%d][%d] PROGMEM = {" %
+              (name, len(tables), SIZE))
+    for t in tables:
+        if len(tables) > 1:
+            print("  {")
+        indent = "    " if len(tables) > 1 else "  "
+        for row in range(0, SIZE, 16):
+            print(indent + ", ".join("%3d" % v for v in t[row:row + 16]) + ",")
+        if len(tables) > 1:
+            print("  },")
+    print("};")
+    print()
+
+
+print("""/**
+ * @file ArduboyTonesWaves.h
+ * \\brief
+ * Wavetables for the sample based engines of the ArduboyTones library.
+ *
+ * \\details
+ * Generated by extras/wavetables.py. Don't edit by hand.
+ */
+
+#ifndef ARDUBOY_TONES_WAVES_H
+#define ARDUBOY_TONES_WAVES_H
+
+#define WAVE_TABLE_SIZE %d
+#define WAVE_BL_LEVELS %d
+""" % (SIZE, LEVELS))
+
+emit("waveSquare", [additive(2 ** (l + 1) - 1, True) for l in range(LEVELS)],
+     "Band limited square waves, indexed by the maximum harmonic level")
+emit("waveSaw", [additive(2 ** (l + 1) - 1, False) for l in range(LEVELS)],
+     "Band limited sawtooth waves, indexed by the maximum harmonic level")
+emit("waveTriangle", [triangle()],
+     "Triangle wave. Its harmonics fall off quickly, so one table is used")
+
+print("#endif")
@@ -6,133 +6,2666 @@
 
 #include "ArduboyTones.h"
 
-// pointer to a function that indicates if sound is enabled
+#if TONES_WAVETABLES
+#include "ArduboyTonesWaves.h"
+#endif
+
+#if TONES_ENGINE == TONES_ENGINE_EDGE && TONES_CHANNELS != 1
+#error "TONES_CHANNELS must be 1 with TONES_ENGINE_EDGE"
+#endif
+
+#if TONES_CHANNELS < 1 || TONES_CHANNELS > 4
+#error "TONES_CHANNELS must be from 1 to 4"
+#endif
+
+#if TONES_QUEUE_SIZE & (TONES_QUEUE_SIZE - 1) || TONES_QUEUE_SIZE > 128
+#error "TONES_QUEUE_SIZE must be 0 or a power of 2, up to 128"
+#endif
+
+#if TONES_CUE_QUEUE_SIZE & (TONES_CUE_QUEUE_SIZE - 1) || \
+    TONES_CUE_QUEUE_SIZE > 128
+#error "TONES_CUE_QUEUE_SIZE must be 0 or a power of 2, up to 128"
+#endif
+
+#if TONES_CUE_PENDSV && (TONES_CUE_QUEUE_SIZE == 0 || TONES_HOST)
+#error "TONES_CUE_PENDSV needs the cue queue, and can't be used with TONES_HOST"
+#endif
+
+#if TONES_QUEUE_CHANNEL >= TONES_CHANNELS
+#error "TONES_QUEUE_CHANNEL must be less than TONES_CHANNELS"
+#endif
+
+#if TONES_WAVETABLES && TONES_ENGINE == TONES_ENGINE_EDGE
+#error "TONES_WAVETABLES needs a sample based TONES_ENGINE"
+#endif
+
+#if TONES_PCM && TONES_ENGINE == TONES_ENGINE_EDGE
+#error "TONES_PCM needs a sample based TONES_ENGINE"
+#endif
+
+#if TONES_NOTE_EFFECTS && TONES_ENGINE == TONES_ENGINE_EDGE
+#error "TONES_NOTE_EFFECTS needs a sample based TONES_ENGINE"
+#endif
+
+#if TONES_NOTE_EFFECTS && TONES_CONTROL_RATE > TONES_SAMPLE_RATE
+#error "TONES_CONTROL_RATE can't be higher than TONES_SAMPLE_RATE"
+#endif
+
+#if TONES_EFFECT_CHANNEL >= TONES_CHANNELS
+#error "TONES_EFFECT_CHANNEL must be less than TONES_CHANNELS"
+#endif
+
+#if TONES_OUTPUT == TONES_OUTPUT_I2S && TONES_ENGINE != TONES_ENGINE_DMA
+#error "TONES_OUTPUT_I2S needs TONES_ENGINE_DMA"
+#endif
+
+#if TONES_OUTPUT == TONES_OUTPUT_PWM && TIMER_IS_TCC && \
+    (TONES_TIMER - TONES_TIMER_TCC0 == TONES_PWM_TCC || TONES_POWER_SAVE)
+#error "TONES_PWM_TCC can't be the timer, or share its clock with TONES_POWER_SAVE"
+#endif
+
+#if TONES_DAC_POWER_DOWN && TONES_OUTPUT != TONES_OUTPUT_DAC
+#error "TONES_DAC_POWER_DOWN needs TONES_OUTPUT_DAC"
+#endif
+
+// With PWM output the edge engine has the TCC generate its square waves
+#define HARDWARE_TONES \
+  (TONES_OUTPUT == TONES_OUTPUT_PWM && TONES_ENGINE == TONES_ENGINE_EDGE)
+
+// With I2S output the transmitter paces the DMA engine, so the TC is unused
+#define ENGINE_TIMER (TONES_OUTPUT != TONES_OUTPUT_I2S)
+
+#if TONES_TIMER == TONES_TIMER_SHARED && \
+    TONES_ENGINE != TONES_ENGINE_FIXED_RATE
+#error "TONES_TIMER_SHARED needs TONES_ENGINE_FIXED_RATE"
+#endif
+
+// Only the fixed rate engine is built for the host. The others need timer
+// and DMA hardware.
+#if TONES_HOST && (TONES_TIMER != TONES_TIMER_SHARED || \
+                   TONES_ENGINE != TONES_ENGINE_FIXED_RATE || \
+                   TONES_POWER_SAVE || TONES_STATS)
+#error "TONES_HOST needs TONES_ENGINE_FIXED_RATE and TONES_TIMER_SHARED, without TONES_POWER_SAVE or TONES_STATS"
+#endif
+
+// Engines which run the timer at a fixed sample rate and synthesize samples
+#define SAMPLE_ENGINE (TONES_ENGINE != TONES_ENGINE_EDGE)
+
+struct ToneChannel;
+
+// Where a channel's sequence values come from: a PROGMEM or RAM array, a
+// packed song, the enqueue() ring buffer or the tonesStream() buffer. Set
+// once when a sequence starts, so each read is a single indirect call
+// instead of a test of a flag for each kind of sequence.
+typedef uint16_t (*SequenceSource)(ToneChannel &ch);
+
+// State of one tone or sequence being played. The edge engine plays a single
+// channel. The sample based engines mix TONES_CHANNELS of them.
+struct ToneChannel
+{
+  volatile uint16_t *start;
+  volatile uint16_t *index;
+  // PROGMEM sequence to switch to at the end of this one, set by tonesNext()
+  const uint16_t * volatile chained;
+  volatile SequenceSource source;
+  volatile bool noteIndexed; // frequencies are NOTE_INDEX_* values
+  bool queueDurNext;
+  volatile bool playing;
+  volatile bool silent;
+  volatile bool highVol;
+#if TONES_CUE_QUEUE_SIZE > 0
+  bool cued; // a cue marker has been reached, so the end is queued too
+#endif
+  uint8_t volume; // 0 to TONES_VOLUME_MAX
+  volatile uint16_t amp; // output level from highVol and volume
+#if TONES_WAVETABLES
+  volatile uint8_t waveform;
+  const uint8_t * volatile wave; // table for the waveform at this pitch
+  uint16_t noise; // noise generator shift register
+#endif
+  uint16_t pitch; // frequency scale for trigger(), 8.8 fixed point
+  uint32_t fineFreq; // toneFine() frequency of the next tone, 0 if none
+
+  // Voice scheduling state for tonesScheduled()
+  uint8_t priority; // 0 if not started by tonesScheduled()
+  uint32_t startOrder; // higher was started more recently
+  uint64_t clockEnd; // clock value at the end, UINT64_MAX if unknown
+  // Time since the sequence started, read by sequenceTime(). Samples for the
+  // sample based engines. For the edge engine, 1/(1024 * F_CPU) second
+  // units, advanced by clockStep at each timer interrupt.
+  uint64_t clock;
+#if SAMPLE_ENGINE
+  volatile long durationCount; // samples left in the tone, -1 for infinite
+  uint16_t durationFrac; // fraction of a sample carried to the next tone
+  uint32_t phase;
+  volatile uint32_t phaseStep;
+#else
+  uint64_t noteEnd; // clock value at the end of the tone
+  uint64_t clockStep;
+  // The half cycle is periodCount + 1 timer ticks, plus periodFrac / 256 of
+  // a tick added through periodAcc
+  uint16_t periodCount;
+  uint8_t periodFrac;
+  uint8_t periodAcc;
+  uint8_t clockShift; // CLOCK_SHIFT_ value of the prescaler in use
+#endif
+
+#if TONES_NOTE_EFFECTS
+  // Note effects of the current tone, updated at each control tick
+  uint8_t fx; // FX_ flags, 0 if none
+  uint16_t fxCountdown; // samples to the next control tick
+  uint32_t fxTicks; // control ticks since the tone started
+  uint16_t fullAmp; // amp without the envelope
+  uint8_t envStage;
+  uint16_t envAttack; // stage lengths in control ticks
+  uint16_t envDecay;
+  uint16_t envRelease;
+  int32_t envSustain; // levels from 0 to ENV_FULL
+  int32_t envLevel;
+  int32_t envDelta; // added to envLevel at each tick
+  uint16_t envLeft; // ticks left in the stage
+  uint32_t releaseAt; // tick the release starts at, UINT32_MAX if never
+  uint32_t baseStep; // phase step before vibrato and arpeggio
+  uint32_t slideTarget;
+  int32_t slideDelta; // added to baseStep at each tick
+  int32_t sweepRate; // baseStep multiplier at each tick, 4.28 fixed point
+  int32_t vibOffset;
+  int32_t vibDelta;
+  uint16_t vibQuarter; // ticks in a quarter of the vibrato cycle
+  uint16_t vibLeft;
+  uint8_t vibCents;
+  uint8_t arpNotes; // semitones above the tone, 4 bits each
+  uint8_t arpIndex;
+  uint16_t arpTicks;
+  uint16_t arpLeft;
+#endif
+
+  // Packed sequence decoder state
+  const uint8_t *packedStart;
+  const uint8_t *packedIndex;
+  const uint8_t *packedTempo;
+  uint16_t packedNote;
+  uint16_t packedDur;
+  uint8_t packedRepeats;
+  bool packedDurNext;
+
+  // Pattern song state. index is the position in the current pattern.
+  const uint16_t * const *patternTable;
+  const uint8_t *orderStart;
+  const uint8_t *orderIndex; // the next order list entry
+  bool patternDurNext;
+};
+
+// pointer to a function that indicates if sound is enabled, or NULL to use
+// the outputOn flag set by setOutputEnabled()
 static bool (*outputEnabled)();
+static volatile bool outputOn = true;
+
+static ToneChannel channels[TONES_CHANNELS];
+
+static volatile uint8_t masterVolume = TONES_VOLUME_MAX;
+
+// Voices mixed into the output: the channels, and the playSample() voice
+#define MIX_VOICES (TONES_CHANNELS + TONES_PCM)
+
+// Channel amplitudes, scaled so that all voices together can't clip. High
+// volume is twice normal, like the original Arduboy's push-pull speaker.
+#define CHANNEL_LEVEL_NORMAL (2048 / MIX_VOICES)
+#define CHANNEL_LEVEL_HIGH   (4095 / MIX_VOICES)
+
+// Output level for each volume level, at normal and high volume, computed at
+// compile time. 3 dB steps from full volume down, with 0 silent.
+#define AMP(l, scale) (((l) * (scale)) >> 8)
+#define AMP_LEVELS(l) { \
+  0, AMP(l, 2), AMP(l, 3), AMP(l, 4), AMP(l, 6), AMP(l, 8), AMP(l, 11), \
+  AMP(l, 16), AMP(l, 23), AMP(l, 32), AMP(l, 45), AMP(l, 64), AMP(l, 91), \
+  AMP(l, 128), AMP(l, 181), (l) \
+}
+static const uint16_t ampTable[2][TONES_VOLUME_MAX + 1] = {
+  AMP_LEVELS(CHANNEL_LEVEL_NORMAL),
+  AMP_LEVELS(CHANNEL_LEVEL_HIGH)
+};
+static uint32_t startCount = 0;
+static volatile bool forceHighVol = false;
+static volatile bool forceNormVol = false;
+static volatile uint32_t dacBusyDrops = 0;
+
+// A sequence for the ISR to start on a channel. The foreground fills in a
+// free one and publishes it with a single pointer store, which the ISR picks
+// up at its next interrupt, so starting or stopping a sequence doesn't stop
+// the timer or hold off the audio interrupt.
+struct PlayRequest
+{
+  volatile uint16_t *tones; // NULL to stop the channel
+  SequenceSource source;
+  bool noteIndexed;
+  uint32_t fineFreq; // for the first tone, from toneFine()
+  volatile bool claimed; // being filled in by the foreground
+  volatile uint16_t toneSequence[MAX_TONES * 2 + 1]; // the tones for tone()
+};
+
+// Enough for a request pending on every channel, one whose tone() sequence
+// is still playing, and one being filled in by each of two foreground
+// contexts, such as the main loop and a lower priority interrupt
+#define REQUEST_COUNT (TONES_CHANNELS + 3)
+
+static PlayRequest requests[REQUEST_COUNT];
+static PlayRequest stopRequest; // tones is NULL
+static PlayRequest * volatile pendingRequest[TONES_CHANNELS];
+
+#if TONES_QUEUE_SIZE > 0
+// Single producer, single consumer ring buffer of frequency/duration pairs.
+// Only the foreground writes queueHead and only the ISR writes queueTail, so
+// no locking is needed. The indices run freely and are masked when used.
+#define QUEUE_MASK (TONES_QUEUE_SIZE - 1)
+
+static volatile uint16_t queueFreq[TONES_QUEUE_SIZE];
+static volatile uint16_t queueDur[TONES_QUEUE_SIZE];
+static volatile uint8_t queueHead = 0;
+static volatile uint8_t queueTail = 0;
+#endif
+
+#if TONES_CUE_QUEUE_SIZE > 0
+// Cue events, in a ring buffer like the enqueue() one but filled by the ISR.
+// Only the ISR writes cueHead and only readCue() writes cueTail.
+#define CUE_MASK (TONES_CUE_QUEUE_SIZE - 1)
+
+static volatile uint16_t cueIds[TONES_CUE_QUEUE_SIZE];
+static volatile uint8_t cueChannels[TONES_CUE_QUEUE_SIZE];
+static volatile uint8_t cueHead = 0;
+static volatile uint8_t cueTail = 0;
+#if TONES_CUE_PENDSV
+static void (* volatile cueCallback)() = NULL;
+#endif
+#endif
+
+// tonesStream() double buffer. Each half is refilled by the foreground and
+// then marked full, and marked empty by the ISR once it has played it, so
+// the reader is never called from the ISR. The halves have an even number
+// of words, so a frequency and its duration are always in the same half.
+static TonesStreamReader streamReader = NULL;
+static volatile uint16_t *streamBuffer;
+static uint16_t streamHalfSize;
+static uint8_t streamChannel = 0;
+static volatile bool streamFull[2];
+static uint16_t streamRead; // ISR's index into the buffer
+static bool streamStalled; // a rest's duration is owed after an underrun
+static volatile uint32_t streamStalls = 0;
+static uint32_t streamOffset; // foreground's next word to read
+static uint8_t streamFillHalf; // the half the foreground refills next
+static bool streamEnded; // TONES_END has been put in the buffer
+
+#if TONES_PCM
+// playSample() voice. The data is decoded a block at a time into pcmBlock,
+// as 8 bit levels, and the ISR steps through the block at the data's rate.
+#define PCM_BLOCK_SIZE 32
+
+static const uint8_t *pcmData;
+static uint32_t pcmLength; // samples in the data
+static uint32_t pcmDecoded; // samples decoded so far
+static uint8_t pcmFormat;
+static uint32_t pcmStep; // data samples per output sample, 16.16 fixed point
+static uint16_t pcmPhase; // fraction of a data sample
+static uint8_t pcmBlock[PCM_BLOCK_SIZE];
+static uint8_t pcmBlockLength;
+static uint8_t pcmBlockPos;
+static int16_t pcmPredictor; // ADPCM decoder state
+static int8_t pcmStepIndex;
+static volatile bool pcmPlaying = false;
+static uint8_t pcmVolume = TONES_VOLUME_MAX;
+static volatile uint16_t pcmAmp;
+#endif
+
+#if TONES_STATS
+static TonesStats statsData;
+static unsigned long statsStart = 0;
+
+// Time the body of an interrupt service routine
+#define STATS_ISR_BEGIN uint32_t statsBegin = DWT->CYCCNT;
+#define STATS_ISR_END statsData.interrupts++; \
+  countCycles(DWT->CYCCNT - statsBegin, \
+              statsData.isrCycles, statsData.isrMaxCycles);
+
+static inline void countCycles(uint32_t cycles, uint32_t &total,
+                               uint32_t &max)
+{
+  total += cycles;
+  if (cycles > max) {
+    max = cycles;
+  }
+}
+#else
+#define STATS_ISR_BEGIN
+#define STATS_ISR_END
+#endif
+
+// Effect sequences for trigger(), and the last command posted. The command
+// packs the pitch, the effect ID and a sequence number into one word, so it
+// can be posted with a single store and nothing can be seen half written.
+// Only the ISR, or setEffects() with the engine locked, writes triggerSeen.
+static const uint16_t * const *effectTable = NULL;
+static uint8_t effectCount = 0;
+static volatile uint32_t triggerCmd = 0;
+static volatile uint8_t triggerSeen = 0;
+static uint8_t triggerNum = 0;
+
+#if SAMPLE_ENGINE
+// Timer compare value giving a match/overflow at the sample rate
+#define SAMPLE_TIMER_COUNT (F_CPU / TONES_SAMPLE_RATE - 1)
+
+// Phase accumulator step for a 1 Hz tone (2^32 / sample rate)
+#define PHASE_STEP_PER_HZ \
+  ((uint32_t)(4294967296.0 / (F_CPU / (SAMPLE_TIMER_COUNT + 1)) + 0.5))
+
+// Samples in a duration unit, times 1024
+#if TONES_DURATION_MS
+#define DURATION_SAMPLES_X1024 (TONES_SAMPLE_RATE * 1024 / 1000)
+#else
+#define DURATION_SAMPLES_X1024 TONES_SAMPLE_RATE
+#endif
+
+// Phase step for a 1/16 Hz frequency, times 4096 (2^40 / sample rate)
+#define FINE_PHASE_STEP_X4096 \
+  ((uint32_t)(1099511627776.0 / (F_CPU / (SAMPLE_TIMER_COUNT + 1)) + 0.5))
+
+#define FINE_PHASE_STEP(fine) \
+  ((uint32_t)(((uint64_t)(fine) * FINE_PHASE_STEP_X4096) >> 12))
+
+// Phase step for each note index, from its exact frequency, generated at
+// compile time
+#define NOTE_PHASE_STEP(n) FINE_PHASE_STEP(NOTE_FINE_##n),
+static const uint32_t notePhaseSteps[NOTE_INDEX_COUNT] = {
+  0, // NOTE_INDEX_REST
+  TONES_NOTE_LIST(NOTE_PHASE_STEP)
+};
+#else
+// Clock units in a duration unit. The clock counts 1/(1024 * F_CPU) second
+// units, so a 1024th of a second is exactly F_CPU of them.
+#if TONES_DURATION_MS
+#if F_CPU % 125
+#error "F_CPU must be a multiple of 125 Hz for TONES_DURATION_MS"
+#endif
+#define DURATION_CLOCK (F_CPU / 125 * 128)
+#else
+#define DURATION_CLOCK F_CPU
+#endif
+
+// Clock units per tick of the timer at each prescaler
+#define CLOCK_SHIFT_DIV16   (10 + 4)
+#define CLOCK_SHIFT_DIV256  (10 + 8)
+#define CLOCK_SHIFT_DIV1024 (10 + 10)
+
+// Half cycles are timed in 1/256ths of a tick of the clk/16 timer clock.
+// The timer count is dithered between the two nearest ticks so the average
+// frequency is exact, where a plain count would be several cents out in
+// the top octaves.
+#define HALF_PERIOD_HZ ((uint32_t)(F_CPU / 16) << 7) // divided by Hz
+#define HALF_PERIOD_FINE ((uint64_t)(F_CPU / 16) << 11) // by 1/16 Hz
+
+// Half cycle for silent tones
+#define SILENT_HALF_PERIOD (HALF_PERIOD_HZ / SILENT_FREQ)
+
+// Half cycle for each note index, from its exact frequency, generated at
+// compile time. Values over 16 bits of ticks are scaled to the clk/256
+// prescaler when used.
+#define NOTE_HALF_PERIOD(n) (uint32_t)(HALF_PERIOD_FINE / NOTE_FINE_##n),
+static const uint32_t noteHalfPeriods[NOTE_INDEX_COUNT] = {
+  SILENT_HALF_PERIOD, // NOTE_INDEX_REST
+  TONES_NOTE_LIST(NOTE_HALF_PERIOD)
+};
+
+static uint32_t timerPrescaler = TC_CTRLA_PRESCALER_DIV16;
+#endif
+
+#if TONES_ENGINE == TONES_ENGINE_DMA
+#define DMA_HALF_SIZE (TONES_DMA_BUFFER_SIZE / 2)
+
+static uint16_t dmaBuffer[TONES_DMA_BUFFER_SIZE];
+static volatile bool dmaRunning = false;
+static volatile uint8_t dmaNextHalf;
+static volatile uint8_t dmaIdleBlocks;
+
+// Descriptor table used if no other library has already enabled the DMAC.
+// The base descriptor of our channel is in whichever table is in use, the
+// descriptor for the second buffer half is linked from it.
+__attribute__((aligned(16))) static DmacDescriptor
+  dmaDescriptors[TONES_DMA_CHANNEL + 1];
+__attribute__((aligned(16))) static DmacDescriptor
+  dmaWriteback[TONES_DMA_CHANNEL + 1];
+__attribute__((aligned(16))) static DmacDescriptor dmaSecondHalf;
+#endif
+
+// ***** Timer backend *****
+// All access to the timer's registers is through these, so the engines
+// don't depend on which timer TONES_TIMER selects. TCs are run as 16 bit
+// counters. TCCs have the same prescaler encoding and match frequency mode,
+// but their registers aren't grouped by counter mode.
+
+#if TONES_TIMER == TONES_TIMER_SHARED
+// The sketch's tick runs all the time. This stands in for the counter's
+// enable bit, so tick() returns straight away while nothing is playing.
+static volatile bool tickEnabled = false;
+
+static inline void timerClock(bool) { }
+static inline void timerSync() { }
+
+static inline bool timerEnabled()
+{
+  return tickEnabled;
+}
+
+static inline void timerEnable(bool enable)
+{
+  tickEnabled = enable;
+}
+
+static inline void timerStopFromISR()
+{
+  tickEnabled = false;
+}
+#else
+#if TIMER_IS_TCC
+#define TIMER_RETRIGGER TCC_CTRLBSET_CMD_RETRIGGER
+#else
+#define TIMER_RETRIGGER TC_CTRLBSET_CMD_RETRIGGER
+#endif
+
+#if TIMER_IS_TCC
+#define TIMER_REGS (*TIMER_CTRL)
+#define TIMER_MODE 0
+#define TIMER_WAVE_MFRQ TCC_WAVE_WAVEGEN_MFRQ
+#define TIMER_SWRST TCC_CTRLA_SWRST
+#else
+#define TIMER_REGS (TIMER_CTRL->COUNT16)
+#define TIMER_MODE TC_CTRLA_MODE_COUNT16
+#define TIMER_WAVE_MFRQ TC_WAVE_WAVEGEN_MFRQ
+#define TIMER_SWRST TC_CTRLA_SWRST
+#endif
+
+// Route the timer's clock to it, or remove it
+static inline void timerClock(bool on)
+{
+  GCLK->PCHCTRL[TIMER_GCLK_ID].bit.CHEN = on;
+  while (GCLK->PCHCTRL[TIMER_GCLK_ID].bit.CHEN != on);
+}
+
+// Wait for any pending synchronised write
+static inline void timerSync()
+{
+  while (TIMER_REGS.SYNCBUSY.reg);
+}
+
+static inline bool timerEnabled()
+{
+  return TIMER_REGS.CTRLA.bit.ENABLE;
+}
+
+static inline void timerEnable(bool enable)
+{
+  TIMER_REGS.CTRLA.bit.ENABLE = enable;
+  while (TIMER_REGS.SYNCBUSY.bit.ENABLE);
+}
+
+// Stop the counter without waiting for the write to sync
+static inline void timerStopFromISR()
+{
+  TIMER_REGS.CTRLA.bit.ENABLE = 0;
+}
+
+// Reset the timer and set it to match frequency mode with the given
+// prescaler, leaving it stopped
+static void timerInit(uint32_t prescaler)
+{
+  GCLK->PCHCTRL[TIMER_GCLK_ID].reg = GCLK_PCHCTRL_GEN_GCLK0_Val | (1 << GCLK_PCHCTRL_CHEN_Pos);
+
+  timerEnable(false);
+
+  TIMER_REGS.CTRLA.reg = TIMER_SWRST;
+  while (TIMER_REGS.SYNCBUSY.bit.SWRST);
+  while (TIMER_REGS.CTRLA.bit.SWRST);
+
+  TIMER_REGS.WAVE.reg = TIMER_WAVE_MFRQ;
+#if TIMER_IS_TCC
+  while (TIMER_REGS.SYNCBUSY.bit.WAVE);
+#endif
+
+  TIMER_REGS.CTRLA.reg = TIMER_MODE | prescaler;
+  while (TIMER_REGS.SYNCBUSY.bit.ENABLE);
+}
+
+// Change the prescaler and restart the count. The counter must be stopped.
+static inline void timerSetPrescaler(uint32_t prescaler)
+{
+  TIMER_REGS.CTRLA.reg = TIMER_MODE | prescaler;
+  while (TIMER_REGS.SYNCBUSY.bit.ENABLE);
+  TIMER_REGS.COUNT.reg = 0;
+  while (TIMER_REGS.SYNCBUSY.bit.COUNT);
+}
+
+// Set the compare value. No sync wait, so it's cheap while running.
+static inline void timerSetCount(uint32_t timerCount)
+{
+  TIMER_REGS.CC[0].reg = timerCount;
+}
+
+static inline void timerEnableInterrupt()
+{
+  TIMER_REGS.INTENSET.bit.MC0 = 1;
+  while (TIMER_REGS.SYNCBUSY.bit.ENABLE);
+}
+
+static inline void timerClearInterrupt()
+{
+  TIMER_REGS.INTFLAG.bit.MC0 = 1;
+}
+
+// Check if the interrupt was raised by the timer, rather than made pending
+// by the foreground
+static inline bool timerMatched()
+{
+  return TIMER_REGS.INTFLAG.bit.MC0;
+}
+
+// Restart the count from 0 without stopping the counter
+static inline void timerRetrigger()
+{
+  TIMER_REGS.CTRLBSET.reg = TIMER_RETRIGGER;
+}
+#endif
+
+// Output backends. One set of these inline functions is compiled, so the
+// ISR writes to the selected output directly.
+#if !TONES_HOST
+#if TONES_OUTPUT != TONES_OUTPUT_DAC
+// Connect an Arduino pin to a peripheral function
+static void muxPin(uint32_t pin, uint8_t function)
+{
+  const PinDescription &desc = g_APinDescription[pin];
+  PortGroup &group = PORT->Group[desc.ulPort];
+
+  if (desc.ulPin & 1) {
+    group.PMUX[desc.ulPin >> 1].bit.PMUXO = function;
+  }
+  else {
+    group.PMUX[desc.ulPin >> 1].bit.PMUXE = function;
+  }
+  group.PINCFG[desc.ulPin].bit.PMUXEN = 1;
+}
+#endif
+
+#if TONES_OUTPUT == TONES_OUTPUT_DAC
+// The sketch's audio setup enables the DAC channel. Nothing is written
+// while it's disabled.
+static inline void outputInit()
+{
+}
+
+static inline bool outputActive()
+{
+  return DAC->DACCTRL[DAC_CH_SPEAKER].bit.ENABLE;
+}
+
+static inline bool outputReady()
+{
+  return DAC_READY && !DAC_DATA_BUSY;
+}
+
+static inline void outputWrite(uint16_t level)
+{
+  DAC->DATA[DAC_CH_SPEAKER].reg = level;
+}
+
+#define OUTPUT_DMA_TRIGGER TIMER_DMAC_TRIGGER
+#define OUTPUT_DMA_ADDR (&DAC->DATA[DAC_CH_SPEAKER].reg)
+#elif TONES_OUTPUT == TONES_OUTPUT_PWM
+#if HARDWARE_TONES
+// The TCC counts the clk/16 timer clock with 4 bits of hardware dithering,
+// so its period is set in 1/16ths of a tick
+#define PWM_PRESCALER  TCC_CTRLA_PRESCALER_DIV16
+#define PWM_RESOLUTION TCC_CTRLA_RESOLUTION_DITH4
+#define PWM_FIRST_PER  ((SILENT_HALF_PERIOD >> 3) - 16)
+#else
+// A 12 bit carrier, so samples are written as they are
+#define PWM_PRESCALER  TCC_CTRLA_PRESCALER_DIV1
+#define PWM_RESOLUTION TCC_CTRLA_RESOLUTION_NONE
+#define PWM_FIRST_PER  4095
+#endif
+
+static void outputInit()
+{
+  GCLK->PCHCTRL[PWM_GCLK_ID].reg = GCLK_PCHCTRL_GEN_GCLK0_Val | (1 << GCLK_PCHCTRL_CHEN_Pos);
+
+  PWM_TCC->CTRLA.bit.ENABLE = 0;
+  while (PWM_TCC->SYNCBUSY.bit.ENABLE);
+  PWM_TCC->CTRLA.reg = TCC_CTRLA_SWRST;
+  while (PWM_TCC->SYNCBUSY.bit.SWRST);
+
+  PWM_TCC->WAVE.reg = TCC_WAVE_WAVEGEN_NPWM;
+  while (PWM_TCC->SYNCBUSY.bit.WAVE);
+  PWM_TCC->PER.reg = PWM_FIRST_PER;
+  PWM_TCC->CC[TONES_PWM_CC].reg = 0; // low until something plays
+  while (PWM_TCC->SYNCBUSY.reg);
+
+  PWM_TCC->CTRLA.reg = PWM_PRESCALER | PWM_RESOLUTION | TCC_CTRLA_ENABLE;
+  while (PWM_TCC->SYNCBUSY.bit.ENABLE);
+
+  muxPin(TONES_PWM_PIN, TONES_PWM_PMUX);
+}
+
+static inline bool outputActive()
+{
+  return true;
+}
+
+// The compare value is buffered, so it can always be written
+static inline bool outputReady()
+{
+  return true;
+}
+
+static inline void outputWrite(uint16_t level)
+{
+  PWM_TCC->CCBUF[TONES_PWM_CC].reg = level;
+}
+
+#if HARDWARE_TONES
+// Play a square wave with a half cycle in 1/256ths of a clk/16 tick, as
+// the edge engine times them. The volume sets the duty cycle, which is 50%
+// at the highest level. The buffered values are loaded at the end of the
+// current cycle, so the change is glitch free.
+static void outputTone(uint32_t halfPeriod, uint16_t amp)
+{
+  uint32_t period = halfPeriod >> 3;
+
+  if (period > 0xFFFFFF) { // below about 7 Hz
+    period = 0xFFFFFF;
+  }
+
+  PWM_TCC->PERBUF.reg = period - 16;
+  PWM_TCC->CCBUF[TONES_PWM_CC].reg = ((uint64_t)period * amp) >> 13;
+}
+
+static inline void outputSilence()
+{
+  PWM_TCC->CCBUF[TONES_PWM_CC].reg = 0;
+}
+#endif
+
+#define OUTPUT_DMA_TRIGGER TIMER_DMAC_TRIGGER
+#define OUTPUT_DMA_ADDR (&PWM_TCC->CCBUF[TONES_PWM_CC].reg)
+#else
+// Bit clocks for each sample, two 16 bit slots, from the I2S clock
+#define I2S_CLOCK_DIV (TONES_I2S_GCLK_HZ / (TONES_SAMPLE_RATE * 32UL))
+
+#if TONES_I2S_GCLK_HZ % (TONES_SAMPLE_RATE * 32UL) || \
+    I2S_CLOCK_DIV < 1 || I2S_CLOCK_DIV > 64
+#error "TONES_I2S_GCLK_HZ must be 1 to 64 times 32 * TONES_SAMPLE_RATE"
+#endif
+
+static void outputInit()
+{
+  MCLK->APBDMASK.bit.I2S_ = 1;
+  GCLK->PCHCTRL[I2S_GCLK_ID_0].reg = GCLK_PCHCTRL_GEN(TONES_I2S_GCLK) | (1 << GCLK_PCHCTRL_CHEN_Pos);
+
+  I2S->CTRLA.reg = I2S_CTRLA_SWRST;
+  while (I2S->SYNCBUSY.bit.SWRST);
+
+  // Standard I2S frames of two 16 bit slots, with the frame sync and bit
+  // clock generated from the clock generator
+  I2S->CLKCTRL[0].reg = I2S_CLKCTRL_MCKSEL_GCLK | I2S_CLKCTRL_SCKSEL_MCKDIV |
+                        I2S_CLKCTRL_FSSEL_SCKDIV | I2S_CLKCTRL_BITDELAY_I2S |
+                        I2S_CLKCTRL_FSWIDTH_HALF | I2S_CLKCTRL_NBSLOTS(1) |
+                        I2S_CLKCTRL_SLOTSIZE_16 |
+                        I2S_CLKCTRL_MCKDIV(I2S_CLOCK_DIV - 1);
+  // Each sample goes to both slots, and is repeated if the DMAC is late
+  I2S->TXCTRL.reg = I2S_TXCTRL_DATASIZE_16 | I2S_TXCTRL_MONO_MONO |
+                    I2S_TXCTRL_TXSAME_SAME;
+
+  I2S->CTRLA.reg = I2S_CTRLA_CKEN0 | I2S_CTRLA_TXEN | I2S_CTRLA_ENABLE;
+  while (I2S->SYNCBUSY.reg);
+
+  muxPin(TONES_I2S_SCK_PIN, 9); // function J
+  muxPin(TONES_I2S_FS_PIN, 9);
+  muxPin(TONES_I2S_SDO_PIN, 9);
+}
+
+// Convert rendered 12 bit levels to signed 16 bit I2S samples in place
+static inline void outputConvert(uint16_t *buf, uint16_t count)
+{
+  while (count--) {
+    *buf = (uint16_t)((*buf - 2048) << 4);
+    buf++;
+  }
+}
+
+#define OUTPUT_DMA_TRIGGER I2S_DMAC_ID_TX_0
+#define OUTPUT_DMA_ADDR (&I2S->TXDATA.reg)
+#endif
+
+#if TONES_OUTPUT != TONES_OUTPUT_I2S
+static inline void outputConvert(uint16_t *buf, uint16_t count)
+{
+  (void)buf;
+  (void)count;
+}
+#endif
+
+#if !HARDWARE_TONES
+static inline void outputSilence()
+{
+}
+#endif
+#endif
+
+#if TONES_POWER_SAVE
+// The timer's clock is only routed to it while it's needed. Its synchronised
+// registers can't be written while the clock is off.
+static volatile bool timerAwake = true;
+static bool dacPoweredDown = false;
+
+static void wakeOutput()
+{
+  if (timerAwake) {
+    return;
+  }
+
+  timerClock(true);
+
+  if (dacPoweredDown) { // only power up the DAC if it was on before
+    DAC->CTRLA.bit.ENABLE = 1;
+    while (DAC->SYNCBUSY.bit.ENABLE);
+    dacPoweredDown = false;
+  }
+
+  timerAwake = true;
+}
+
+// Remove the clock from the stopped timer, and power down the DAC if allowed
+static void sleepOutput()
+{
+  if (!timerAwake) {
+    return;
+  }
+
+  timerSync(); // finish any pending write
+  timerClock(false);
+
+#if TONES_DAC_POWER_DOWN
+  if (DAC->CTRLA.bit.ENABLE) {
+    DAC->CTRLA.bit.ENABLE = 0;
+    while (DAC->SYNCBUSY.bit.ENABLE);
+    dacPoweredDown = true;
+  }
+#endif
+
+  timerAwake = false;
+}
+#endif
+
+void enable_counter(boolean enable)
+{
+#if TONES_POWER_SAVE
+  if (enable) {
+    wakeOutput();
+  }
+  else if (!timerAwake) {
+    return; // already stopped, and a write couldn't sync without the clock
+  }
+#endif
+  timerEnable(enable);
+}
+
+#if TONES_ENGINE != TONES_ENGINE_FIXED_RATE
+// Stop the timer because nothing needs timing. With TONES_POWER_SAVE the
+// timer's clock is also removed. The fixed rate engine's ISR stops its own
+// timer instead.
+static void stopTimer()
+{
+  enable_counter(false);
+#if TONES_POWER_SAVE
+  sleepOutput();
+#endif
+}
+#endif
+
+// Check if sound is enabled, without a function call in the push model
+static inline bool soundOn()
+{
+  return outputEnabled != NULL ? outputEnabled() : outputOn;
+}
+
+// In the push model nothing plays while muted, so the timer isn't run
+static inline bool stoppedByMute()
+{
+  return outputEnabled == NULL && !outputOn;
+}
+
+// Decode the next value of a packed sequence, returning the same note index
+// and duration values that a noteTones() sequence would contain. Only the
+// current event is held in RAM.
+static uint16_t getNextPacked(ToneChannel &ch)
+{
+  uint8_t note;
+  uint8_t code;
+  const uint8_t *tempo;
+
+  if (ch.packedDurNext) { // the note has been returned, now its duration
+    ch.packedDurNext = false;
+    return ch.packedDur;
+  }
+
+  if (ch.packedRepeats != 0) { // still in a run of the same event
+    ch.packedRepeats--;
+  }
+  else {
+    note = pgm_read_byte(ch.packedIndex++);
+
+    if ((note & ~TONES_PACKED_HIGH_VOLUME) == TONES_PACKED_END) {
+      ch.packedIndex--; // stay on the marker
+      return TONES_END;
+    }
+    if ((note & ~TONES_PACKED_HIGH_VOLUME) == TONES_PACKED_REPEAT) {
+      ch.packedIndex = ch.packedStart; // reset to the first event
+      return TONES_REPEAT;
+    }
+
+    code = pgm_read_byte(ch.packedIndex++);
+    tempo = ch.packedTempo + ((code & 0x0F) * 2);
+    ch.packedDur = pgm_read_byte(tempo) | (pgm_read_byte(tempo + 1) << 8);
+    ch.packedRepeats = code >> 4;
+    ch.packedNote = note & ~TONES_PACKED_HIGH_VOLUME;
+    if (note & TONES_PACKED_HIGH_VOLUME) {
+      ch.packedNote |= TONE_HIGH_VOLUME;
+    }
+  }
+
+  ch.packedDurNext = true;
+  return ch.packedNote;
+}
+
+// The first byte of TONES_ORDER_LOOP()
+#define ORDER_LOOP 0xFD
+
+// Where a pattern song starts, so the first read moves to the first
+// pattern, and where it stays once it has ended
+static const uint16_t patternSongStart[] PROGMEM = { TONES_END };
+static const uint8_t patternSongEnd[] PROGMEM = { TONES_ORDER_END };
+
+// Get the next value of a pattern song. At the end of each pattern the
+// next one is found from the order list, so only tones, and a final
+// TONES_END, are returned.
+static uint16_t getNextPattern(ToneChannel &ch)
+{
+  uint16_t value;
+  uint8_t entry;
+
+  if (ch.patternDurNext) { // the frequency has been returned, now its duration
+    ch.patternDurNext = false;
+    return pgm_read_word(ch.index++);
+  }
+
+  // Stop if no tone is found in a whole pass of the order list, which only
+  // has empty patterns
+  for (uint16_t tries = 0; tries < 256; tries++) {
+    value = pgm_read_word(ch.index);
+    if (value != TONES_END && value != TONES_REPEAT) {
+      ch.index++;
+      ch.patternDurNext = true;
+      return value;
+    }
+
+    entry = pgm_read_byte(ch.orderIndex++);
+    if (entry == TONES_ORDER_REPEAT) {
+      ch.orderIndex = ch.orderStart;
+      entry = pgm_read_byte(ch.orderIndex++);
+    }
+    else if (entry == ORDER_LOOP) {
+      ch.orderIndex = ch.orderStart + pgm_read_byte(ch.orderIndex);
+      entry = pgm_read_byte(ch.orderIndex++);
+    }
+
+    if (entry >= ORDER_LOOP) {
+      break; // the end, or a repeat or loop to one
+    }
+    ch.index = (uint16_t *)ch.patternTable[entry];
+  }
+
+  ch.index = (uint16_t *)patternSongStart;
+  ch.orderIndex = patternSongEnd;
+  return TONES_END;
+}
+
+#if TONES_QUEUE_SIZE > 0
+// Consume the next value from the ring buffer. An empty buffer ends the
+// sequence. enqueue() starts it again.
+static uint16_t getNextQueued(ToneChannel &ch)
+{
+  uint8_t tail = queueTail;
+
+  if (ch.queueDurNext) {
+    ch.queueDurNext = false;
+    queueTail = tail + 1; // the slot is free once both values are read
+    return queueDur[tail & QUEUE_MASK];
+  }
+
+  if (tail == queueHead) {
+    return TONES_END;
+  }
+
+  ch.queueDurNext = true;
+  return queueFreq[tail & QUEUE_MASK];
+}
+
+static void flushQueue()
+{
+  queueTail = queueHead;
+  channels[TONES_QUEUE_CHANNEL].queueDurNext = false;
+}
+#else
+static void flushQueue()
+{
+}
+#endif
+
+#if TONES_CUE_QUEUE_SIZE > 0
+// Queue a cue event for readCue(), and run the callback once the ISR has
+// returned. Dropped if the queue is full.
+static void postCue(ToneChannel &ch, uint16_t id)
+{
+  uint8_t head = cueHead;
+
+  ch.cued = true;
+  if ((uint8_t)(head - cueTail) >= TONES_CUE_QUEUE_SIZE) {
+    return;
+  }
+
+  cueIds[head & CUE_MASK] = id;
+  cueChannels[head & CUE_MASK] = &ch - channels;
+  cueHead = head + 1; // publish the slot only after it's been written
+
+#if TONES_CUE_PENDSV
+  if (cueCallback != NULL) {
+    SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+  }
+#endif
+}
+
+// Queue the end of a sequence, only if it carries cue markers. Plain tone()
+// and tones() sequences don't fill the queue with events nobody reads.
+static inline void postEndCue(ToneChannel &ch)
+{
+  if (ch.cued) {
+    postCue(ch, TONES_CUE_END);
+  }
+}
+#else
+static inline void postCue(ToneChannel &ch, uint16_t id)
+{
+  (void)ch;
+  (void)id;
+}
+
+static inline void postEndCue(ToneChannel &ch)
+{
+  (void)ch;
+}
+#endif
+
+// Consume the next value from the tonesStream() buffer. If the foreground
+// hasn't refilled the next half yet, a rest lasting one duration unit is
+// played rather than waiting for it.
+static uint16_t getNextStreamed(ToneChannel &)
+{
+  uint16_t value;
+  uint8_t half = (streamRead >= streamHalfSize);
+
+  if (streamStalled) {
+    streamStalled = false;
+    return 1;
+  }
+
+  if (!streamFull[half]) {
+    streamStalls++;
+    streamStalled = true;
+    return NOTE_REST;
+  }
+
+  value = streamBuffer[streamRead];
+  if (value == TONES_END && !(streamRead & 1)) {
+    return TONES_END; // stay on the marker
+  }
+
+  if (++streamRead == streamHalfSize * 2) {
+    streamRead = 0;
+  }
+  if (streamRead == 0 || streamRead == streamHalfSize) {
+    streamFull[half] = false; // played, so it can be refilled
+  }
+  return value;
+}
+
+// Fill one half of the tonesStream() buffer. Repeat markers are followed
+// here, so the ISR only ever sees tones and a final TONES_END. Buffer
+// positions have the same parity as stream offsets, so frequencies are at
+// even positions.
+static void fillStreamHalf(uint8_t half)
+{
+  volatile uint16_t *buf = streamBuffer + half * streamHalfSize;
+  uint16_t n = 0;
+  uint16_t want;
+  uint16_t got;
+  uint16_t i;
+
+  while (n < streamHalfSize && !streamEnded) {
+    want = streamHalfSize - n;
+    got = streamReader(streamOffset, (uint16_t *)buf + n, want);
+    if (got > want) {
+      got = want;
+    }
+
+    for (i = (n + 1) & ~1; i < n + got; i += 2) {
+      if (buf[i] == TONES_END || buf[i] == TONES_REPEAT) {
+        break;
+      }
+    }
+
+    if (i < n + got) { // found a marker
+      if (buf[i] == TONES_REPEAT && streamOffset + (i - n) != 0) {
+        streamOffset = 0; // carry on reading from the start
+        n = i;
+        continue;
+      }
+      buf[i] = TONES_END; // an end, or a repeat of nothing
+      streamEnded = true;
+      break;
+    }
+
+    streamOffset += got;
+    n += got;
+
+    if (got < want) {
+      // The end of the data, without a marker. A frequency left without
+      // its duration is dropped.
+      buf[n & ~1] = TONES_END;
+      streamEnded = true;
+    }
+  }
+
+  streamFull[half] = true;
+}
+
+static uint16_t getNextProgmem(ToneChannel &ch)
+{
+  return pgm_read_word(ch.index++);
+}
+
+static uint16_t getNextRAM(ToneChannel &ch)
+{
+  return *ch.index++;
+}
+
+// Get the next value in a channel's sequence
+static inline uint16_t getNext(ToneChannel &ch)
+{
+  return ch.source(ch);
+}
+
+// Switch to a chained sequence in place, instead of ending or repeating.
+// Returns the first frequency value of the new sequence.
+static uint16_t chainSequence(ToneChannel &ch)
+{
+  ch.start = ch.index = (uint16_t *)ch.chained;
+  ch.chained = NULL;
+  ch.source = getNextProgmem;
+  ch.noteIndexed = false;
+  ch.pitch = TONES_PITCH_NORMAL;
+  return getNext(ch);
+}
+
+#if TONES_NOTE_EFFECTS
+// Note effects in use by a tone
+#define FX_ENVELOPE 0x01
+#define FX_SLIDE    0x02
+#define FX_SWEEP    0x04
+#define FX_VIBRATO  0x08
+#define FX_ARPEGGIO 0x10
+#define FX_PITCH (FX_SLIDE | FX_SWEEP | FX_VIBRATO | FX_ARPEGGIO)
+
+// Envelope stages, in the order they're played
+#define ENV_ATTACK  0
+#define ENV_DECAY   1
+#define ENV_SUSTAIN 2
+#define ENV_RELEASE 3
+#define ENV_DONE    4
+
+// Envelope level of the full output level, 8.24 fixed point
+#define ENV_FULL (1L << 24)
+
+// A channel's output level scaled by its envelope
+static inline uint16_t envelopeAmp(ToneChannel &ch)
+{
+  return ((uint32_t)ch.fullAmp * (ch.envLevel >> 8)) >> 16;
+}
+#else
+// Skip the effect commands before a tone, starting with value, and return
+// the first value that isn't one. Without TONES_NOTE_EFFECTS the notes play
+// as if the commands weren't there, but cue markers are still queued.
+static uint16_t readEffects(ToneChannel &ch, uint16_t value)
+{
+  uint16_t param;
+
+  while (value >= TONES_FX_FIRST) {
+    param = getNext(ch); // the command's parameter
+    if (value == TONES_FX_CUE) {
+      postCue(ch, param);
+    }
+    value = getNext(ch);
+  }
+  return value;
+}
+#endif
+
+// Combine a voice's volume with the master volume. The levels are in 3 dB
+// steps, so the two volumes are combined by adding them.
+static uint8_t mixLevel(uint8_t volume)
+{
+  int8_t level = volume + masterVolume - TONES_VOLUME_MAX;
+
+  if (level < 0 || volume == 0) {
+    level = 0;
+  }
+  return level;
+}
+
+// Set a channel's output level from its volume, the master volume and its
+// high volume state
+static void updateAmp(ToneChannel &ch)
+{
+  ch.amp = ampTable[ch.highVol][mixLevel(ch.volume)];
+#if TONES_NOTE_EFFECTS
+  ch.fullAmp = ch.amp;
+  if (ch.fx & FX_ENVELOPE) {
+    ch.amp = envelopeAmp(ch);
+  }
+#endif
+}
+
+#if TONES_WAVETABLES
+// Choose the table for a waveform at a pitch. For the band limited waves,
+// the table with the most harmonics below half the sample rate is used.
+static const uint8_t *selectWave(uint8_t waveform, uint32_t step)
+{
+  int8_t level = WAVE_BL_LEVELS - 1;
+
+  if (step != 0) {
+    level = __builtin_clz(step) - 2; // harmonics up to 2^31 / step
+    if (level < 0) {
+      level = 0;
+    }
+    else if (level > WAVE_BL_LEVELS - 1) {
+      level = WAVE_BL_LEVELS - 1;
+    }
+  }
+
+  switch (waveform) {
+    case TONES_WAVE_TRIANGLE:
+      return waveTriangle;
+    case TONES_WAVE_SAW:
+      return waveSaw[level];
+    case TONES_WAVE_SINE:
+      return waveSquare[0]; // the fundamental alone
+    default:
+      return waveSquare[level];
+  }
+}
+#endif
+
+// Apply a trigger() pitch to a frequency, keeping it in the playable range
+static uint16_t scalePitch(uint16_t freq, uint16_t pitch)
+{
+  uint32_t scaled = ((uint32_t)freq * pitch) >> 8;
+
+  if (freq == 0) {
+    return 0;
+  }
+  if (scaled < 16) {
+    return 16;
+  }
+  if (scaled > 0x7FFF) {
+    return 0x7FFF;
+  }
+  return scaled;
+}
+
+static bool anyPlaying()
+{
+  for (uint8_t i = 0; i < TONES_CHANNELS; i++) {
+    if (channels[i].playing) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Check if anything needs the engine running, a channel or a sample
+static inline bool anySound()
+{
+#if TONES_PCM
+  if (pcmPlaying) {
+    return true;
+  }
+#endif
+  return anyPlaying();
+}
+
+#if TONES_ENGINE == TONES_ENGINE_DMA
+static void setDescriptor(DmacDescriptor *desc, uint16_t *half,
+                          DmacDescriptor *next)
+{
+  desc->BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_BLOCKACT_INT |
+                     DMAC_BTCTRL_BEATSIZE_HWORD | DMAC_BTCTRL_SRCINC;
+  desc->BTCNT.reg = DMA_HALF_SIZE;
+  // With address incrementing, the source address is the end of the block
+  desc->SRCADDR.reg = (uint32_t)(half + DMA_HALF_SIZE);
+  desc->DSTADDR.reg = (uint32_t)OUTPUT_DMA_ADDR;
+  desc->DESCADDR.reg = (uint32_t)next;
+}
+
+static void stopEngine()
+{
+#if ENGINE_TIMER
+  stopTimer();
+#endif
+
+  DMAC->Channel[TONES_DMA_CHANNEL].CHCTRLA.bit.ENABLE = 0;
+  while (DMAC->Channel[TONES_DMA_CHANNEL].CHCTRLA.bit.ENABLE);
+  DMAC->Channel[TONES_DMA_CHANNEL].CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+  NVIC_ClearPendingIRQ(TONES_DMA_IRQ);
+
+  dmaRunning = false;
+}
+
+static void startEngine()
+{
+  DmacDescriptor *first;
+
+  if (dmaRunning) {
+    return;
+  }
+
+  // Share the descriptor table of another library if it got the DMAC first
+  if (!DMAC->CTRL.bit.DMAENABLE) {
+    DMAC->BASEADDR.reg = (uint32_t)dmaDescriptors;
+    DMAC->WRBADDR.reg = (uint32_t)dmaWriteback;
+    DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xf);
+  }
+  first = (DmacDescriptor *)DMAC->BASEADDR.reg + TONES_DMA_CHANNEL;
+
+  // Both halves are rendered up front. The half just played is re-rendered
+  // from the block interrupt while the other half plays.
+  ArduboyTones::fillBuffer(dmaBuffer, TONES_DMA_BUFFER_SIZE);
+  outputConvert(dmaBuffer, TONES_DMA_BUFFER_SIZE);
+  dmaNextHalf = 0;
+  dmaIdleBlocks = 0;
+
+  setDescriptor(first, dmaBuffer, &dmaSecondHalf);
+  setDescriptor(&dmaSecondHalf, dmaBuffer + DMA_HALF_SIZE, first);
+
+  DMAC->Channel[TONES_DMA_CHANNEL].CHCTRLA.reg = DMAC_CHCTRLA_SWRST;
+  while (DMAC->Channel[TONES_DMA_CHANNEL].CHCTRLA.bit.SWRST);
+  DMAC->Channel[TONES_DMA_CHANNEL].CHCTRLA.reg = (
+    DMAC_CHCTRLA_TRIGSRC(OUTPUT_DMA_TRIGGER) |
+    DMAC_CHCTRLA_TRIGACT_BURST |
+    DMAC_CHCTRLA_BURSTLEN_SINGLE
+  );
+  DMAC->Channel[TONES_DMA_CHANNEL].CHINTENSET.reg = DMAC_CHINTENSET_TCMPL;
+  DMAC->Channel[TONES_DMA_CHANNEL].CHCTRLA.bit.ENABLE = 1;
+
+  dmaRunning = true;
+#if ENGINE_TIMER
+  enable_counter(true);
+#endif
+}
+
+// Keep the block interrupt out while the foreground changes a channel. The
+// engine keeps running so other channels play on without a gap. The change
+// is heard once the already rendered samples have played.
+static void lockEngine()
+{
+  NVIC_DisableIRQ(TONES_DMA_IRQ);
+}
+
+static void unlockEngine()
+{
+  if (anySound()) {
+    startEngine();
+  }
+  NVIC_EnableIRQ(TONES_DMA_IRQ);
+}
+#elif TONES_ENGINE == TONES_ENGINE_FIXED_RATE
+// Keep the sample interrupt out while the foreground changes a channel. The
+// counter keeps running at the sample rate, so nothing needs resyncing.
+static void lockEngine()
+{
+  NVIC_DisableIRQ(TIMER_IRQ);
+}
+
+static void unlockEngine()
+{
+  if (anySound() && !timerEnabled()) {
+    enable_counter(true);
+  }
+  NVIC_EnableIRQ(TIMER_IRQ);
+}
+#endif
+
+#if SAMPLE_ENGINE
+// The phase step for a frequency, or a note index in a noteTones()
+// sequence, without its high volume bit
+static uint32_t phaseStepFor(ToneChannel &ch, uint16_t freq)
+{
+  if (ch.noteIndexed) {
+    if (freq >= NOTE_INDEX_COUNT) {
+      freq = NOTE_INDEX_REST;
+    }
+    return notePhaseSteps[freq];
+  }
+
+  if (ch.pitch != TONES_PITCH_NORMAL) {
+    freq = scalePitch(freq, ch.pitch);
+  }
+  // No divide needed, and the step is exact to within 1/65536 Hz
+  return freq * PHASE_STEP_PER_HZ;
+}
+
+#if TONES_NOTE_EFFECTS
+// Samples in a control tick
+#define CONTROL_SAMPLES (TONES_SAMPLE_RATE / TONES_CONTROL_RATE)
+
+// Highest phase step, at half the sample rate
+#define MAX_PHASE_STEP 0x7FFFFFFFUL
+
+// Phase step multiplier per control tick for a sweep of 1/16 semitone per
+// second, 4.28 fixed point. The change at each tick is small enough for
+// ln(2) times the exponent to stand in for the power of 2.
+#define SWEEP_RATE_PER_UNIT ((int32_t)(268435456.0 * 0.69314718056 / \
+                                       (12 * 16) / TONES_CONTROL_RATE + 0.5))
+
+// Vibrato depth of one cent as a fraction of the phase step, 0.32 fixed
+// point
+#define VIBRATO_PER_CENT ((uint32_t)(4294967296.0 * 0.69314718056 / 1200 + 0.5))
+
+// Frequency ratios of 0 to 15 semitones for arpeggios, 16.16 fixed point
+static const uint32_t semitoneRatios[16] = {
+  65536, 69433, 73562, 77936, 82570, 87480, 92682, 98193,
+  104032, 110218, 116772, 123715, 131072, 138866, 147123, 155872
+};
+
+// Remove the effects of the previous tone
+static inline void clearEffects(ToneChannel &ch)
+{
+  ch.fx = 0;
+  ch.envAttack = 0;
+  ch.envDecay = 0;
+  ch.envRelease = 0;
+  ch.envSustain = ENV_FULL;
+}
+
+// Read the effect commands before a tone, starting with value, and return
+// the first value that isn't one. Unknown commands are skipped.
+static uint16_t readEffects(ToneChannel &ch, uint16_t value)
+{
+  uint16_t param;
+
+  while (value >= TONES_FX_FIRST) {
+    param = getNext(ch);
+
+    switch (value & 0xFF00) {
+      case TONES_FX_ATTACK:
+        ch.fx |= FX_ENVELOPE;
+        ch.envAttack = param;
+        break;
+      case TONES_FX_DECAY:
+        ch.fx |= FX_ENVELOPE;
+        ch.envDecay = param;
+        ch.envSustain = (value & 0xFF) * (ENV_FULL / 255);
+        break;
+      case TONES_FX_RELEASE:
+        ch.fx |= FX_ENVELOPE;
+        ch.envRelease = param;
+        break;
+      case TONES_FX_SLIDE:
+        ch.fx |= FX_SLIDE;
+        ch.slideTarget = phaseStepFor(ch, param & ~TONE_HIGH_VOLUME);
+        break;
+      case TONES_FX_SWEEP:
+        ch.fx |= FX_SWEEP;
+        ch.sweepRate = (int16_t)param * SWEEP_RATE_PER_UNIT;
+        break;
+      case TONES_FX_VIBRATO:
+        ch.fx |= FX_VIBRATO;
+        ch.vibCents = value & 0xFF;
+        ch.vibQuarter = (param != 0) ? param : 1;
+        break;
+      case TONES_FX_ARPEGGIO:
+        ch.fx |= FX_ARPEGGIO;
+        ch.arpNotes = value & 0xFF;
+        ch.arpTicks = (param != 0) ? param : 1;
+        break;
+      case TONES_FX_CUE:
+        if (value == TONES_FX_CUE) {
+          postCue(ch, param);
+        }
+        break;
+    }
+
+    value = getNext(ch);
+  }
+  return value;
+}
+
+// Move a channel's envelope to a stage, setting the step to take at each
+// control tick to reach the stage's end level
+static void setEnvelopeStage(ToneChannel &ch, uint8_t stage)
+{
+  ch.envStage = stage;
+  ch.envDelta = 0;
+  ch.envLeft = 0;
+
+  switch (stage) {
+    case ENV_ATTACK:
+      ch.envLeft = ch.envAttack;
+      ch.envDelta = (ENV_FULL - ch.envLevel) / ch.envAttack;
+      break;
+    case ENV_DECAY:
+      if (ch.envDecay != 0) {
+        ch.envLeft = ch.envDecay;
+        ch.envDelta = (ch.envSustain - ch.envLevel) / ch.envDecay;
+        break;
+      }
+      ch.envStage = ENV_SUSTAIN;
+      // fall through
+    case ENV_SUSTAIN:
+      ch.envLevel = ch.envSustain;
+      break;
+    case ENV_RELEASE:
+      ch.envLeft = ch.envRelease;
+      ch.envDelta = -ch.envLevel / ch.envRelease;
+      break;
+    default:
+      ch.envLevel = 0;
+      break;
+  }
+}
+
+// Set up the effects read for a tone, once its phase step and duration are
+// known. Any divides are done here, so each control tick only adds steps.
+static void startEffects(ToneChannel &ch)
+{
+  uint32_t ticks = UINT32_MAX; // control ticks in the tone
+
+  if (ch.fx == 0) {
+    return;
+  }
+
+  if (ch.durationCount >= 0) {
+    ticks = ch.durationCount / CONTROL_SAMPLES;
+  }
+  ch.fxTicks = 0;
+  ch.fxCountdown = CONTROL_SAMPLES;
+  ch.baseStep = ch.phaseStep;
+
+  if (ch.fx & FX_ENVELOPE) {
+    ch.releaseAt = UINT32_MAX;
+    if (ch.envRelease != 0 && ticks != UINT32_MAX) {
+      ch.releaseAt = (ticks > ch.envRelease) ? ticks - ch.envRelease : 0;
+    }
+    ch.envLevel = (ch.envAttack != 0) ? 0 : ENV_FULL;
+    setEnvelopeStage(ch, (ch.envAttack != 0) ? ENV_ATTACK : ENV_DECAY);
+    ch.amp = envelopeAmp(ch);
+  }
+
+  if (ch.fx & FX_SLIDE) {
+    // A slide is spread over the tone, so one lasting forever can't slide
+    if (ticks == UINT32_MAX || ticks == 0) {
+      ch.fx &= ~FX_SLIDE;
+    }
+    else {
+      ch.slideDelta = (int32_t)(ch.slideTarget - ch.baseStep) / (int32_t)ticks;
+    }
+  }
+
+  if (ch.fx & FX_VIBRATO) {
+    ch.vibOffset = 0;
+    ch.vibDelta = (((uint64_t)ch.baseStep * ch.vibCents * VIBRATO_PER_CENT)
+                   >> 32) / ch.vibQuarter;
+    ch.vibLeft = ch.vibQuarter;
+  }
+
+  if (ch.fx & FX_ARPEGGIO) {
+    ch.arpIndex = 0;
+    ch.arpLeft = ch.arpTicks;
+  }
+}
+
+// Update a channel's effects at a control tick. The envelope and pitch
+// change by a step computed when the tone started, or by a multiply for an
+// exponential sweep or an arpeggio note.
+static void controlTick(ToneChannel &ch)
+{
+  uint64_t step;
+  uint8_t semitones;
+
+  ch.fxTicks++;
+
+  if (ch.fx & FX_ENVELOPE) {
+    if (ch.fxTicks >= ch.releaseAt && ch.envStage < ENV_RELEASE) {
+      setEnvelopeStage(ch, ENV_RELEASE);
+    }
+    if (ch.envLeft != 0) {
+      ch.envLevel += ch.envDelta;
+      if (--ch.envLeft == 0) {
+        setEnvelopeStage(ch, ch.envStage + 1);
+      }
+    }
+    ch.amp = envelopeAmp(ch);
+  }
+
+  if (!(ch.fx & FX_PITCH)) {
+    return;
+  }
+
+  if (ch.fx & FX_SLIDE) {
+    ch.baseStep += ch.slideDelta;
+  }
+  if (ch.fx & FX_SWEEP) {
+    step = ch.baseStep + (((int64_t)ch.baseStep * ch.sweepRate) >> 28);
+    ch.baseStep = (step > MAX_PHASE_STEP) ? MAX_PHASE_STEP : step;
+  }
+
+  step = ch.baseStep;
+  if (ch.fx & FX_ARPEGGIO) {
+    if (--ch.arpLeft == 0) {
+      ch.arpLeft = ch.arpTicks;
+      ch.arpIndex = (ch.arpIndex == 2) ? 0 : ch.arpIndex + 1;
+    }
+    if (ch.arpIndex != 0) {
+      semitones = (ch.arpIndex == 1) ? ch.arpNotes >> 4 : ch.arpNotes & 0xF;
+      step = (step * semitoneRatios[semitones]) >> 16;
+    }
+  }
+  if (ch.fx & FX_VIBRATO) {
+    ch.vibOffset += ch.vibDelta;
+    if (--ch.vibLeft == 0) {
+      ch.vibDelta = -ch.vibDelta;
+      ch.vibLeft = ch.vibQuarter * 2;
+    }
+    step += ch.vibOffset;
+  }
+
+  ch.phaseStep = (step > MAX_PHASE_STEP) ? MAX_PHASE_STEP : step;
+#if TONES_WAVETABLES
+  ch.wave = selectWave(ch.waveform, ch.phaseStep);
+#endif
+}
+#endif
+
+static void nextChannelTone(ToneChannel &ch)
+{
+  uint16_t freq;
+  uint16_t dur;
+  uint32_t samples;
+
+#if TONES_NOTE_EFFECTS
+  clearEffects(ch);
+#endif
+
+  freq = readEffects(ch, getNext(ch)); // get tone frequency
+
+  // A chained sequence takes over from an end or repeat marker, so the
+  // transition is seamless
+  if ((freq == TONES_END || freq == TONES_REPEAT) && ch.chained != NULL) {
+    freq = readEffects(ch, chainSequence(ch));
+  }
+
+  if (freq == TONES_END) { // if freq is actually an "end of sequence" marker
+    // The engine stops itself once the rendered samples have played out
+    ch.playing = false;
+    postEndCue(ch);
+    return;
+  }
+
+  ch.playing = true;
+
+  if (freq == TONES_REPEAT) { // if frequency is actually a "repeat" marker
+    ch.index = ch.start; // reset to start of sequence
+    freq = readEffects(ch, getNext(ch));
+  }
+
+  if (((freq & TONE_HIGH_VOLUME) || forceHighVol) && !forceNormVol) {
+    ch.highVol = true;
+  }
+  else {
+    ch.highVol = false;
+  }
+  updateAmp(ch);
+
+  freq &= ~TONE_HIGH_VOLUME; // strip volume indicator from frequency
+  if (ch.fineFreq != 0) { // only for the tone started by toneFine()
+    ch.phaseStep = FINE_PHASE_STEP(ch.fineFreq);
+    ch.fineFreq = 0;
+  }
+  else {
+    ch.phaseStep = phaseStepFor(ch, freq);
+  }
+
+#if TONES_WAVETABLES
+  ch.wave = selectWave(ch.waveform, ch.phaseStep);
+#endif
+
+  ch.silent = (ch.phaseStep == 0) || !soundOn();
+
+  dur = getNext(ch); // get tone duration
+  if (dur != 0) {
+    // Durations are counted in samples. The fraction of a sample left over
+    // is carried into the next tone, so no error builds up over a sequence.
+    samples = (uint32_t)dur * DURATION_SAMPLES_X1024 + ch.durationFrac;
+    ch.durationCount = samples >> 10;
+    ch.durationFrac = samples & 0x3FF;
+  }
+  else {
+    ch.durationCount = -1; // indicate infinite duration
+  }
+
+#if TONES_NOTE_EFFECTS
+  startEffects(ch);
+#endif
+}
+
+#endif
+
+// Start a channel's next tone, timing it if TONES_STATS is enabled
+static inline void timedNextTone(ToneChannel &ch)
+{
+#if TONES_STATS
+  uint32_t begin = DWT->CYCCNT;
+#endif
+
+#if SAMPLE_ENGINE
+  nextChannelTone(ch);
+#else
+  ArduboyTones::nextTone();
+#endif
+
+#if TONES_STATS
+  statsData.transitions++;
+  countCycles(DWT->CYCCNT - begin,
+              statsData.nextToneCycles, statsData.nextToneMaxCycles);
+#endif
+}
+
+#if SAMPLE_ENGINE
+// Add a channel's samples to the mix buffer
+static void mixChannel(ToneChannel &ch, uint16_t *buf, uint16_t count)
+{
+  uint16_t n;
+  uint16_t amp;
+  uint32_t p;
+  uint32_t step;
+#if TONES_WAVETABLES
+  const uint8_t *wave;
+  uint16_t noise;
+#endif
+
+  while (count != 0 && ch.playing) {
+    if (ch.durationCount == 0) {
+      timedNextTone(ch);
+      continue;
+    }
+
+    // Render up to the end of the current tone in one run
+    n = count;
+#if TONES_NOTE_EFFECTS
+    // or up to the next control tick, if it has effects
+    if (ch.fx != 0) {
+      if (ch.fxCountdown == 0) {
+        controlTick(ch);
+        ch.fxCountdown = CONTROL_SAMPLES;
+      }
+      if (ch.fxCountdown < n) {
+        n = ch.fxCountdown;
+      }
+    }
+#endif
+    if (ch.durationCount > 0) {
+      if (ch.durationCount < n) {
+        n = ch.durationCount;
+      }
+      ch.durationCount -= n;
+    }
+    count -= n;
+    ch.clock += n;
+#if TONES_NOTE_EFFECTS
+    ch.fxCountdown -= n;
+#endif
+
+    if (ch.silent) {
+      buf += n;
+      continue;
+    }
+
+    amp = ch.amp;
+    p = ch.phase;
+    step = ch.phaseStep;
+#if TONES_WAVETABLES
+    if (ch.waveform == TONES_WAVE_NOISE) {
+      // The shift register is clocked each time the phase wraps, so the
+      // frequency sets the noise pitch
+      noise = ch.noise;
+      while (n--) {
+        if (noise & 1) {
+          *buf += amp;
+        }
+        buf++;
+        p += step;
+        if (p < step) {
+          noise = (noise >> 1) ^ (-(noise & 1) & 0xB400);
+        }
+      }
+      ch.noise = noise;
+    }
+    else if (ch.waveform != TONES_WAVE_SQUARE) {
+      wave = ch.wave;
+      while (n--) {
+        *buf += (pgm_read_byte(wave + (p >> 24)) * amp) >> 8;
+        buf++;
+        p += step;
+      }
+    }
+    else
+#endif
+    {
+      while (n--) {
+        if (!(p & 0x80000000)) {
+          *buf += amp;
+        }
+        buf++;
+        p += step;
+      }
+    }
+    ch.phase = p;
+  }
+}
+
+#if TONES_PCM
+// IMA ADPCM step sizes, and the change in step index for each code
+static const int16_t adpcmSteps[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41,
+  45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190,
+  209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+  876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499,
+  2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845,
+  8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350,
+  22385, 24623, 27086, 29794, 32767
+};
+static const int8_t adpcmIndexChange[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+// Decode one ADPCM code to an 8 bit level
+static uint8_t decodeAdpcm(uint8_t code)
+{
+  int16_t step = adpcmSteps[pcmStepIndex];
+  int32_t diff = step >> 3;
+  int32_t predictor = pcmPredictor;
+
+  if (code & 4) {
+    diff += step;
+  }
+  if (code & 2) {
+    diff += step >> 1;
+  }
+  if (code & 1) {
+    diff += step >> 2;
+  }
+  predictor += (code & 8) ? -diff : diff;
+  if (predictor > 32767) {
+    predictor = 32767;
+  }
+  else if (predictor < -32768) {
+    predictor = -32768;
+  }
+  pcmPredictor = predictor;
+
+  pcmStepIndex += adpcmIndexChange[code & 7];
+  if (pcmStepIndex < 0) {
+    pcmStepIndex = 0;
+  }
+  else if (pcmStepIndex > 88) {
+    pcmStepIndex = 88;
+  }
+
+  return (predictor >> 8) + 128;
+}
+
+// Decode the next block of the sample, or end it if there's no more data
+static void decodePcmBlock()
+{
+  uint8_t n = PCM_BLOCK_SIZE;
+  uint8_t byte;
+
+  if (pcmLength - pcmDecoded < n) {
+    n = pcmLength - pcmDecoded;
+  }
+
+  if (pcmFormat == TONES_PCM_ADPCM) {
+    for (uint8_t i = 0; i < n; i++) {
+      byte = pgm_read_byte(pcmData + ((pcmDecoded + i) >> 1));
+      pcmBlock[i] = decodeAdpcm(((pcmDecoded + i) & 1) ? byte >> 4 :
+                                                         byte & 0x0F);
+    }
+  }
+  else {
+    for (uint8_t i = 0; i < n; i++) {
+      pcmBlock[i] = pgm_read_byte(pcmData + pcmDecoded + i);
+    }
+  }
+
+  pcmDecoded += n;
+  pcmBlockLength = n;
+  if (n == 0) {
+    pcmPlaying = false;
+  }
+}
+
+// Add the playSample() voice to the mix buffer. Each output sample takes a
+// multiply and a step of the position through the decoded block.
+static void mixSample(uint16_t *buf, uint16_t count)
+{
+  uint16_t amp = pcmAmp;
+  uint32_t pos;
+
+  while (count != 0 && pcmPlaying) {
+    if (pcmBlockPos >= pcmBlockLength) {
+      // The step can pass the end of the block, if the data's rate is
+      // higher than the output's
+      pcmBlockPos -= pcmBlockLength;
+      decodePcmBlock();
+      continue;
+    }
+
+    *buf++ += (pcmBlock[pcmBlockPos] * amp) >> 8;
+    count--;
+
+    pos = pcmPhase + pcmStep;
+    pcmPhase = pos;
+    pcmBlockPos += pos >> 16;
+  }
+}
+#endif
+#else
+// Set by startTimer(), so unlockEngine() knows a new count was programmed
+static bool timerStarted = false;
+
+// Keep the timer interrupt out while the foreground changes the channel.
+// The counter keeps running, so a change that doesn't start a tone, or
+// that's dropped, leaves the tone playing exactly as it was.
+static void lockEngine()
+{
+  NVIC_DisableIRQ(TIMER_IRQ);
+  timerStarted = false;
+}
+
+// A tone started under the lock has changed the compare value with the
+// counter running, possibly to below its count, so the count restarts from
+// 0. A match the old tone raised in the meantime is cleared with it, so it
+// isn't taken as the end of the new tone's first half cycle.
+static void unlockEngine()
+{
+  if (timerStarted && timerEnabled()) {
+    timerRetrigger();
+    timerClearInterrupt();
+  }
+#if TONES_POWER_SAVE
+  if (!timerEnabled()) {
+    sleepOutput();
+  }
+#endif
+  NVIC_EnableIRQ(TIMER_IRQ);
+}
+
+// Set the compare value and prescaler and run the timer. The prescaler can
+// only be changed with the counter stopped.
+static void startTimer(uint32_t timerCount, uint32_t prescaler)
+{
+#if TONES_POWER_SAVE
+  wakeOutput();
+#endif
+
+  if (prescaler != timerPrescaler) {
+    enable_counter(false);
+    timerSetPrescaler(prescaler);
+    timerPrescaler = prescaler;
+  }
+
+  timerSetCount(timerCount);
+  if (!timerEnabled()) { // no sync wait if running
+    enable_counter(true);
+  }
+  timerStarted = true;
+}
+#endif
+
+// Keep the audio interrupt out for a change that doesn't start or stop a
+// channel, with none of the restarting lockEngine() and unlockEngine() do.
+static inline void holdEngine()
+{
+#if TONES_ENGINE == TONES_ENGINE_DMA
+  NVIC_DisableIRQ(TONES_DMA_IRQ);
+#else
+  NVIC_DisableIRQ(TIMER_IRQ);
+#endif
+}
+
+static inline void releaseEngine()
+{
+#if TONES_ENGINE == TONES_ENGINE_DMA
+  NVIC_EnableIRQ(TONES_DMA_IRQ);
+#else
+  NVIC_EnableIRQ(TIMER_IRQ);
+#endif
+}
+
+// Start playing a channel once its sequence has been set up. The engine
+// must be locked, or this must be called from the ISR.
+static void startChannel(ToneChannel &ch,
+                         uint16_t pitch = TONES_PITCH_NORMAL)
+{
+  ch.pitch = pitch;
+  ch.priority = 0;
+  ch.startOrder = ++startCount;
+  ch.clockEnd = UINT64_MAX;
+  ch.clock = 0;
+#if TONES_CUE_QUEUE_SIZE > 0
+  ch.cued = false;
+#endif
+#if SAMPLE_ENGINE
+  ch.durationCount = 0;
+  ch.durationFrac = 0;
+#else
+  ch.noteEnd = 0;
+#endif
+
+  if (stoppedByMute()) {
+    ch.playing = false;
+    ch.fineFreq = 0;
+    return;
+  }
+
+  timedNextTone(ch); // start playing
+}
+
+// Start the effect posted by trigger(), if there's a new one. Called from
+// the ISR at each interrupt. Returns true if an effect was started.
+static bool pickUpTrigger()
+{
+  uint32_t cmd = triggerCmd;
+  ToneChannel &ch = channels[TONES_EFFECT_CHANNEL];
+
+  if ((uint8_t)cmd == triggerSeen) {
+    return false;
+  }
+  triggerSeen = cmd;
+
+  ch.source = getNextProgmem;
+  ch.noteIndexed = false;
+  ch.chained = NULL;
+  ch.start = ch.index = (uint16_t *)effectTable[(uint8_t)(cmd >> 8)];
+  startChannel(ch, cmd >> 16);
+  return true;
+}
+
+// Check if the timer is running, so the ISR will pick up a trigger()
+static inline bool engineRunning()
+{
+#if TONES_HOST
+  return false; // nothing runs in an interrupt, fillBuffer() is pulled
+#elif TONES_ENGINE == TONES_ENGINE_DMA
+  return dmaRunning;
+#else
+  return timerEnabled();
+#endif
+}
+
+// Start or stop a channel as requested by the foreground. Returns true if
+// there was a request. The pointer is taken with an exchange, so a request
+// is only ever picked up once, by the ISR or by flushRequest(), and the
+// foreground can reuse it from then on.
+static bool pickUpRequest(uint8_t channel)
+{
+  PlayRequest *r = __atomic_exchange_n(&pendingRequest[channel],
+                                       (PlayRequest *)NULL, __ATOMIC_ACQUIRE);
+
+  if (r == NULL) {
+    return false;
+  }
+
+  ToneChannel &ch = channels[channel];
+  ch.chained = NULL;
+  if (r->tones == NULL) {
+    ch.playing = false;
+    if (channel == TONES_QUEUE_CHANNEL) {
+      flushQueue();
+    }
+  }
+  else {
+    ch.source = r->source;
+    ch.noteIndexed = r->noteIndexed;
+    ch.fineFreq = r->fineFreq;
+    ch.start = ch.index = r->tones;
+    startChannel(ch);
+  }
+  return true;
+}
+
+// A stop leaves the edge engine's timer to be stopped by whoever picked it
+// up
+static inline void stopIfIdle()
+{
+#if TONES_ENGINE == TONES_ENGINE_EDGE
+  if (!channels[0].playing) {
+    stopTimer();
+    outputSilence();
+  }
+#endif
+}
+
+// Start or stop channels as requested by the foreground. Called from the
+// ISR at each interrupt, before anything else. Returns true if any channel
+// was changed.
+static bool pickUpRequests()
+{
+  bool changed = false;
+
+  for (uint8_t i = 0; i < TONES_CHANNELS; i++) {
+    changed |= pickUpRequest(i);
+  }
+
+  if (changed) {
+    stopIfIdle();
+  }
+  return changed;
+}
+
+// Apply a request still pending on a channel before the foreground changes
+// the channel directly, so the two take effect in the order they were
+// made. Otherwise the ISR would pick the older request up afterwards and
+// undo the change. Called with the engine locked or held.
+static void flushRequest(uint8_t channel)
+{
+  if (pickUpRequest(channel)) {
+    stopIfIdle();
+  }
+}
+
+// The same, for a foreground function that doesn't otherwise lock the
+// engine. Nothing is locked unless a request is pending.
+static void flushRequestUnlocked(uint8_t channel)
+{
+  if (pendingRequest[channel] != NULL) {
+    lockEngine();
+    flushRequest(channel);
+    unlockEngine();
+  }
+}
+
+// Check if a request is free to fill in: not pending, and not holding a
+// tone() sequence a channel is playing
+static bool requestInUse(PlayRequest &r)
+{
+  for (uint8_t i = 0; i < TONES_CHANNELS; i++) {
+    if (pendingRequest[i] == &r || channels[i].start == r.toneSequence) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Claim a free request for the foreground to fill in. One is always free
+// unless more foreground contexts than REQUEST_COUNT allows for are
+// starting sequences at the same time, when this waits for the ISR.
+static PlayRequest *claimRequest()
+{
+  while (true) {
+    for (uint8_t i = 0; i < REQUEST_COUNT; i++) {
+      PlayRequest &r = requests[i];
+
+      if (__atomic_exchange_n(&r.claimed, true, __ATOMIC_ACQUIRE)) {
+        continue; // another context is filling it in
+      }
+      if (!requestInUse(r)) {
+        return &r;
+      }
+      r.claimed = false;
+    }
+  }
+}
+
+// Hand a request to the ISR. It replaces any request still pending on the
+// channel. If the engine isn't running, there's no interrupt to pick it up,
+// so it's started here instead.
+static void publishRequest(uint8_t channel, PlayRequest *r)
+{
+  pendingRequest[channel] = r;
+  r->claimed = false;
+
+  if (!engineRunning()) {
+    lockEngine();
+    pickUpRequests();
+    unlockEngine();
+  }
+#if TONES_ENGINE == TONES_ENGINE_EDGE
+  else {
+    // Don't wait for the end of the current half cycle, or of a rest with
+    // TONES_POWER_SAVE, which could be half a second away
+    NVIC_SetPendingIRQ(TIMER_IRQ);
+  }
+#endif
+}
+
+// Publish a request to play a sequence
+static void requestSequence(uint8_t channel, PlayRequest *r,
+                            volatile uint16_t *tones, bool progmem,
+                            bool noteIndexed = false, uint32_t fineFreq = 0)
+{
+  r->tones = tones;
+  r->source = progmem ? getNextProgmem : getNextRAM;
+  r->noteIndexed = noteIndexed;
+  r->fineFreq = fineFreq;
+  publishRequest(channel, r);
+}
+
+// Start a sequence on a channel. The engine must be locked.
+static void startSequence(uint8_t channel, volatile uint16_t *tones,
+                          bool progmem, bool noteIndexed = false)
+{
+  ToneChannel &ch = channels[channel];
+
+  ch.source = progmem ? getNextProgmem : getNextRAM;
+  ch.noteIndexed = noteIndexed;
+  ch.chained = NULL;
+  ch.start = ch.index = tones; // set to start of sequence array
+  startChannel(ch);
+}
+
+// The total duration of a PROGMEM sequence, or UINT32_MAX if it repeats or
+// has a tone of infinite duration
+static uint32_t sequenceLength(const uint16_t *tones)
+{
+  uint32_t length = 0;
+  uint16_t freq;
+  uint16_t dur;
+
+  while (true) {
+    freq = pgm_read_word(tones++);
+    if (freq == TONES_END) {
+      return length;
+    }
+    if (freq == TONES_REPEAT) {
+      return UINT32_MAX;
+    }
+    dur = pgm_read_word(tones++);
+    if (freq >= TONES_FX_FIRST) {
+      continue; // an effect command and its parameter
+    }
+    if (dur == 0) {
+      return UINT32_MAX;
+    }
+    length += dur;
+  }
+}
+
+// Channel time left, in clock units. The engine must be locked.
+static uint64_t remainingTime(ToneChannel &ch)
+{
+  return (ch.clock < ch.clockEnd) ? ch.clockEnd - ch.clock : 0;
+}
+
+// Check if channel a is a better voice to steal than channel b: a lower
+// priority, then less time left to play, then started longer ago
+static bool betterVictim(ToneChannel &a, ToneChannel &b)
+{
+  uint64_t leftA;
+  uint64_t leftB;
+
+  if (a.priority != b.priority) {
+    return a.priority < b.priority;
+  }
+  leftA = remainingTime(a);
+  leftB = remainingTime(b);
+  if (leftA != leftB) {
+    return leftA < leftB;
+  }
+  return (int32_t)(a.startOrder - b.startOrder) < 0;
+}
+
+ArduboyTones::ArduboyTones(boolean (*outEn)(), uint8_t irqPriority)
+{
+  outputEnabled = outEn;
+
+  for (uint8_t i = 0; i < TONES_CHANNELS; i++) {
+    channels[i].volume = TONES_VOLUME_MAX;
+    channels[i].source = getNextProgmem;
+#if TONES_WAVETABLES
+    channels[i].wave = waveSquare[0];
+    channels[i].noise = 0xACE1;
+#endif
+  }
+
+#if TONES_ENGINE == TONES_ENGINE_DMA
+#if ENGINE_TIMER
+  // Overflow at the sample rate, with no prescaler. The overflow only
+  // triggers the DMAC, so no timer interrupt is needed.
+  timerInit(TC_CTRLA_PRESCALER_DIV1);
+  timerSetCount(SAMPLE_TIMER_COUNT);
+  timerSync();
+#endif
+
+  // Configure the DMA block interrupt request
+  NVIC_DisableIRQ(TONES_DMA_IRQ);
+  NVIC_ClearPendingIRQ(TONES_DMA_IRQ);
+  NVIC_SetPriority(TONES_DMA_IRQ, irqPriority);
+  NVIC_EnableIRQ(TONES_DMA_IRQ);
+#elif TONES_TIMER == TONES_TIMER_SHARED
+  // The sketch owns the tick interrupt and sets its rate and priority
+  (void)irqPriority;
+#else
+#if TONES_ENGINE == TONES_ENGINE_FIXED_RATE
+  // Interrupt at the sample rate, with no prescaler
+  timerInit(TC_CTRLA_PRESCALER_DIV1);
+  timerSetCount(SAMPLE_TIMER_COUNT);
+  timerSync();
+#else
+  // clk/16 prescaler, with the count set by each tone
+  timerInit(TC_CTRLA_PRESCALER_DIV16);
+#endif
+
+  // Configure interrupt request
+  NVIC_DisableIRQ(TIMER_IRQ);
+  NVIC_ClearPendingIRQ(TIMER_IRQ);
+  NVIC_SetPriority(TIMER_IRQ, irqPriority);
+  NVIC_EnableIRQ(TIMER_IRQ);
+
+  // Enable interrupt request
+  timerEnableInterrupt();
+#endif
+
+#if TONES_CUE_PENDSV
+  NVIC_SetPriority(PendSV_IRQn, (1 << __NVIC_PRIO_BITS) - 1);
+#endif
+
+#if !TONES_HOST
+  outputInit();
+#endif
+
+#if TONES_POWER_SAVE && ENGINE_TIMER
+  sleepOutput(); // until there's something to play
+#endif
+
+#if TONES_STATS
+  // Enable the cycle counter
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+void ArduboyTones::tone(uint16_t freq, uint16_t dur)
+{
+  PlayRequest *r = claimRequest();
+
+  r->toneSequence[0] = freq;
+  r->toneSequence[1] = dur;
+  r->toneSequence[2] = TONES_END; // set end marker
+  requestSequence(0, r, r->toneSequence, false);
+}
+
+void ArduboyTones::tone(uint16_t freq1, uint16_t dur1,
+                        uint16_t freq2, uint16_t dur2)
+{
+  PlayRequest *r = claimRequest();
+
+  r->toneSequence[0] = freq1;
+  r->toneSequence[1] = dur1;
+  r->toneSequence[2] = freq2;
+  r->toneSequence[3] = dur2;
+  r->toneSequence[4] = TONES_END; // set end marker
+  requestSequence(0, r, r->toneSequence, false);
+}
+
+void ArduboyTones::tone(uint16_t freq1, uint16_t dur1,
+                        uint16_t freq2, uint16_t dur2,
+                        uint16_t freq3, uint16_t dur3)
+{
+  PlayRequest *r = claimRequest();
+
+  r->toneSequence[0] = freq1;
+  r->toneSequence[1] = dur1;
+  r->toneSequence[2] = freq2;
+  r->toneSequence[3] = dur2;
+  r->toneSequence[4] = freq3;
+  r->toneSequence[5] = dur3;
+  r->toneSequence[6] = TONES_END; // set end marker
+  requestSequence(0, r, r->toneSequence, false);
+}
+
+void ArduboyTones::toneWords(const uint16_t *words, uint8_t count)
+{
+  PlayRequest *r = claimRequest();
+
+  for (uint8_t i = 0; i < count; i++) {
+    r->toneSequence[i] = words[i];
+  }
+  r->toneSequence[count] = TONES_END; // set end marker
+  requestSequence(0, r, r->toneSequence, false);
+}
+
+void ArduboyTones::toneFine(uint32_t freq, uint16_t dur)
+{
+  PlayRequest *r = claimRequest();
+
+  if (freq != 0 && freq < 16 * 16) {
+    freq = 16 * 16;
+  }
+  else if (freq > 0x7FFF * 16) {
+    freq = 0x7FFF * 16;
+  }
+
+  // The whole hertz value stands in for the frequency, which is given to
+  // the ISR separately
+  r->toneSequence[0] = (freq + 8) >> 4;
+  r->toneSequence[1] = dur;
+  r->toneSequence[2] = TONES_END;
+  requestSequence(0, r, r->toneSequence, false, false, freq);
+}
+
+void ArduboyTones::tones(const uint16_t *tones)
+{
+  ArduboyTones::tones(tones, 0);
+}
+
+void ArduboyTones::tones(const uint16_t *tones, uint8_t channel)
+{
+  if (channel >= TONES_CHANNELS) {
+    return;
+  }
+
+  requestSequence(channel, claimRequest(), (uint16_t *)tones, true);
+}
+
+void ArduboyTones::tonesNext(const uint16_t *tones)
+{
+  ArduboyTones::tonesNext(tones, 0);
+}
+
+void ArduboyTones::tonesNext(const uint16_t *tones, uint8_t channel)
+{
+  if (channel >= TONES_CHANNELS) {
+    return;
+  }
+
+  ToneChannel &ch = channels[channel];
+
+  // A sequence requested just before is what this one follows
+  flushRequestUnlocked(channel);
+
+  // Publish first, then check. If the ISR reached the end of the sequence
+  // before seeing the chained one, it has already marked the channel as not
+  // playing, so it's started here instead.
+  ch.chained = tones;
+  if (!ch.playing) {
+    lockEngine();
+    if (!ch.playing && ch.chained != NULL) {
+      startSequence(channel, (uint16_t *)tones, true);
+    }
+    unlockEngine();
+  }
+}
+
+void ArduboyTones::noteTones(const uint16_t *notes)
+{
+  ArduboyTones::noteTones(notes, 0);
+}
+
+void ArduboyTones::noteTones(const uint16_t *notes, uint8_t channel)
+{
+  if (channel >= TONES_CHANNELS) {
+    return;
+  }
+
+  requestSequence(channel, claimRequest(), (uint16_t *)notes, true, true);
+}
+
+void ArduboyTones::tonesPacked(const uint8_t *song)
+{
+  ArduboyTones::tonesPacked(song, 0);
+}
+
+void ArduboyTones::tonesPacked(const uint8_t *song, uint8_t channel)
+{
+  uint8_t tempoCount;
+
+  if (channel >= TONES_CHANNELS) {
+    return;
+  }
+
+  ToneChannel &ch = channels[channel];
+  tempoCount = pgm_read_byte(song);
+
+  lockEngine();
+  flushRequest(channel);
+  ch.packedTempo = song + 1;
+  ch.packedStart = ch.packedIndex = song + 1 + tempoCount * 2;
+  ch.packedRepeats = 0;
+  ch.packedDurNext = false;
+  ch.noteIndexed = true;
+  ch.source = getNextPacked;
+  ch.chained = NULL;
+  startChannel(ch);
+  unlockEngine();
+}
+
+// Start a pattern song's order lists on consecutive channels, all in the
+// same lock so they start on the same sample
+static void startPatterns(const uint16_t * const *patterns,
+                          const uint8_t *order, uint8_t count,
+                          uint8_t firstChannel, bool noteIndexed)
+{
+  uint8_t entry;
+
+  if (firstChannel >= TONES_CHANNELS) {
+    return;
+  }
+  if (count > TONES_CHANNELS - firstChannel) {
+    count = TONES_CHANNELS - firstChannel;
+  }
 
-static volatile long durationToggleCount = 0;
-static volatile bool tonesPlaying = false;
-static volatile bool toneSilent;
-static volatile bool toneHighVol;
-static volatile bool forceHighVol = false;
-static volatile bool forceNormVol = false;
+  lockEngine();
+  for (uint8_t i = firstChannel; i < firstChannel + count; i++) {
+    ToneChannel &ch = channels[i];
 
-static volatile uint16_t *tonesStart;
-static volatile uint16_t *tonesIndex;
-static volatile uint16_t toneSequence[MAX_TONES * 2 + 1];
-static volatile bool inProgmem;
+    flushRequest(i);
+    ch.patternTable = patterns;
+    ch.orderStart = ch.orderIndex = order;
+    ch.start = ch.index = (uint16_t *)patternSongStart;
+    ch.patternDurNext = false;
+    ch.noteIndexed = noteIndexed;
+    ch.source = getNextPattern;
+    ch.chained = NULL;
+    startChannel(ch);
 
-void enable_counter(boolean enable)
+    // The next channel's list follows this one's end marker
+    do {
+      entry = pgm_read_byte(order++);
+      if (entry == ORDER_LOOP) {
+        order++; // the loop position
+      }
+    } while (entry < ORDER_LOOP);
+  }
+  unlockEngine();
+}
+
+void ArduboyTones::tonesPatterns(const uint16_t * const *patterns,
+                                 const uint8_t *order, uint8_t channels,
+                                 uint8_t firstChannel)
 {
-  TIMER_CTRL->COUNT16.CTRLA.bit.ENABLE = enable;
-  while (TIMER_CTRL->COUNT16.SYNCBUSY.bit.ENABLE);
+  startPatterns(patterns, order, channels, firstChannel, false);
 }
 
-ArduboyTones::ArduboyTones(boolean (*outEn)())
+void ArduboyTones::notePatterns(const uint16_t * const *patterns,
+                                const uint8_t *order, uint8_t channels,
+                                uint8_t firstChannel)
 {
-  outputEnabled = outEn;
+  startPatterns(patterns, order, channels, firstChannel, true);
+}
 
-  toneSequence[MAX_TONES * 2] = TONES_END;
+void ArduboyTones::tonesInRAM(uint16_t *tones)
+{
+  ArduboyTones::tonesInRAM(tones, 0);
+}
 
-  // Enable GCLK for timer
-  GCLK->PCHCTRL[TIMER_GCLK_ID].reg = GCLK_PCHCTRL_GEN_GCLK0_Val | (1 << GCLK_PCHCTRL_CHEN_Pos);
+void ArduboyTones::tonesInRAM(uint16_t *tones, uint8_t channel)
+{
+  if (channel >= TONES_CHANNELS) {
+    return;
+  }
 
-  // Disable counter
-  enable_counter(false);
+  requestSequence(channel, claimRequest(), tones, false);
+}
 
-  // Reset counter
-  TIMER_CTRL->COUNT16.CTRLA.reg = TC_CTRLA_SWRST;
-  while (TIMER_CTRL->COUNT16.SYNCBUSY.bit.ENABLE);
-  while (TIMER_CTRL->COUNT16.CTRLA.bit.SWRST);
+void ArduboyTones::noTone()
+{
+  // The engine stops itself once nothing is playing
+  for (uint8_t i = 0; i < TONES_CHANNELS; i++) {
+    publishRequest(i, &stopRequest);
+  }
+#if TONES_PCM
+  pcmPlaying = false;
+#endif
+}
 
-  // Set to match frequency mode
-  TIMER_CTRL->COUNT16.WAVE.reg = TC_WAVE_WAVEGEN_MFRQ;
+void ArduboyTones::noTone(uint8_t channel)
+{
+  if (channel >= TONES_CHANNELS) {
+    return;
+  }
 
-  // Set to 16-bit counter, clk/16 prescaler
-  TIMER_CTRL->COUNT16.CTRLA.reg = (
-    TC_CTRLA_MODE_COUNT16 |
-    TC_CTRLA_PRESCALER_DIV16
-  );
-  while (TIMER_CTRL->COUNT16.SYNCBUSY.bit.ENABLE);
+  publishRequest(channel, &stopRequest);
+}
 
-  // Configure interrupt request
-  NVIC_DisableIRQ(TIMER_IRQ);
-  NVIC_ClearPendingIRQ(TIMER_IRQ);
-  NVIC_SetPriority(TIMER_IRQ, 0);
-  NVIC_EnableIRQ(TIMER_IRQ);
+void ArduboyTones::setOutputEnabled(bool enabled)
+{
+  outputEnabled = NULL; // from now on only the flag is used
+  outputOn = enabled;
 
-  // Enable interrupt request
-  TIMER_CTRL->COUNT16.INTENSET.bit.MC0 = 1;
-  while (TIMER_CTRL->COUNT16.SYNCBUSY.bit.ENABLE);
+  if (!enabled) {
+    noTone(); // stop the timer rather than playing silently
+  }
 }
 
-void ArduboyTones::tone(uint16_t freq, uint16_t dur)
+void ArduboyTones::setVolume(uint8_t level)
 {
-  enable_counter(false);
+  setVolume(0, level);
+}
+
+void ArduboyTones::setVolume(uint8_t channel, uint8_t level)
+{
+  if (channel >= TONES_CHANNELS) {
+    return;
+  }
 
-  inProgmem = false;
-  tonesStart = tonesIndex = toneSequence; // set to start of sequence array
-  toneSequence[0] = freq;
-  toneSequence[1] = dur;
-  toneSequence[2] = TONES_END; // set end marker
-  nextTone(); // start playing
+  // Takes effect immediately. If the ISR starts a tone in between, it
+  // computes the same level.
+  channels[channel].volume = (level > TONES_VOLUME_MAX) ?
+                             TONES_VOLUME_MAX : level;
+  updateAmp(channels[channel]);
 }
 
-void ArduboyTones::tone(uint16_t freq1, uint16_t dur1,
-                        uint16_t freq2, uint16_t dur2)
+void ArduboyTones::setMasterVolume(uint8_t level)
 {
-  enable_counter(false);
+  masterVolume = (level > TONES_VOLUME_MAX) ? TONES_VOLUME_MAX : level;
 
-  inProgmem = false;
-  tonesStart = tonesIndex = toneSequence; // set to start of sequence array
-  toneSequence[0] = freq1;
-  toneSequence[1] = dur1;
-  toneSequence[2] = freq2;
-  toneSequence[3] = dur2;
-  toneSequence[4] = TONES_END; // set end marker
-  nextTone(); // start playing
+  for (uint8_t i = 0; i < TONES_CHANNELS; i++) {
+    updateAmp(channels[i]);
+  }
+#if TONES_PCM
+  pcmAmp = ampTable[1][mixLevel(pcmVolume)];
+#endif
 }
 
-void ArduboyTones::tone(uint16_t freq1, uint16_t dur1,
-                        uint16_t freq2, uint16_t dur2,
-                        uint16_t freq3, uint16_t dur3)
+#if TONES_PCM
+void ArduboyTones::playSample(const uint8_t *data, uint32_t length,
+                              uint16_t rate, uint8_t format)
 {
-  enable_counter(false);
+  // One divide here, so the ISR only adds the step
+  uint32_t step = ((uint32_t)rate << 16) / TONES_SAMPLE_RATE;
 
-  inProgmem = false;
-  tonesStart = tonesIndex = toneSequence; // set to start of sequence array
-  toneSequence[0] = freq1;
-  toneSequence[1] = dur1;
-  toneSequence[2] = freq2;
-  toneSequence[3] = dur2;
-  toneSequence[4] = freq3;
-  toneSequence[5] = dur3;
-  // end marker was set in the constructor and will never change
-  nextTone(); // start playing
+  if (!soundOn() || length == 0 || step == 0) {
+    return;
+  }
+
+  lockEngine();
+  pcmData = data;
+  pcmLength = length;
+  pcmFormat = format;
+  pcmStep = step;
+  pcmDecoded = 0;
+  pcmPhase = 0;
+  pcmBlockPos = 0;
+  pcmPredictor = 0;
+  pcmStepIndex = 0;
+  pcmAmp = ampTable[1][mixLevel(pcmVolume)];
+  pcmPlaying = true;
+  decodePcmBlock();
+  unlockEngine();
 }
 
-void ArduboyTones::tones(const uint16_t *tones)
+void ArduboyTones::stopSample()
 {
-  enable_counter(false);
+  lockEngine();
+  pcmPlaying = false;
+  unlockEngine();
+}
 
-  inProgmem = true;
-  tonesStart = tonesIndex = (uint16_t *)tones; // set to start of sequence array
-  nextTone(); // start playing
+bool ArduboyTones::samplePlaying()
+{
+  return pcmPlaying;
 }
 
-void ArduboyTones::tonesInRAM(uint16_t *tones)
+void ArduboyTones::setSampleVolume(uint8_t level)
 {
-  enable_counter(false);
+  pcmVolume = (level > TONES_VOLUME_MAX) ? TONES_VOLUME_MAX : level;
+  pcmAmp = ampTable[1][mixLevel(pcmVolume)];
+}
+#endif
 
-  inProgmem = false;
-  tonesStart = tonesIndex = tones; // set to start of sequence array
-  nextTone(); // start playing
+#if TONES_WAVETABLES
+void ArduboyTones::setWaveform(uint8_t waveform)
+{
+  setWaveform(0, waveform);
 }
 
-void ArduboyTones::noTone()
+void ArduboyTones::setWaveform(uint8_t channel, uint8_t waveform)
 {
-  enable_counter(false);
-  tonesPlaying = false;
+  if (channel >= TONES_CHANNELS) {
+    return;
+  }
+
+  ToneChannel &ch = channels[channel];
+
+  // The table is set before the waveform, so the ISR never sees a table
+  // waveform without a valid table
+  ch.wave = selectWave(waveform, ch.phaseStep);
+  ch.waveform = waveform;
 }
+#endif
 
 void ArduboyTones::volumeMode(uint8_t mode)
 {
@@ -149,101 +2682,669 @@ void ArduboyTones::volumeMode(uint8_t mode)
 
 bool ArduboyTones::playing()
 {
-  return tonesPlaying;
+  for (uint8_t i = 0; i < TONES_CHANNELS; i++) {
+    if (playing(i)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ArduboyTones::playing(uint8_t channel)
+{
+  PlayRequest *r;
+
+  if (channel >= TONES_CHANNELS) {
+    return false;
+  }
+
+  // A sequence requested but not yet started is counted as playing, and
+  // one that has been asked to stop isn't
+  r = pendingRequest[channel];
+  if (r != NULL) {
+    return r->tones != NULL && !stoppedByMute();
+  }
+  return channels[channel].playing;
+}
+
+#if TONES_QUEUE_SIZE > 0
+bool ArduboyTones::enqueue(uint16_t freq, uint16_t dur)
+{
+  ToneChannel &ch = channels[TONES_QUEUE_CHANNEL];
+  uint8_t head;
+
+  if (stoppedByMute()) {
+    return true; // accepted, but muted tones are discarded
+  }
+
+  // A noTone() requested just before flushes the queue, so it's applied
+  // before this tone is added
+  flushRequestUnlocked(TONES_QUEUE_CHANNEL);
+
+  head = queueHead;
+  if ((uint8_t)(head - queueTail) >= TONES_QUEUE_SIZE) {
+    return false; // full
+  }
+
+  queueFreq[head & QUEUE_MASK] = freq;
+  queueDur[head & QUEUE_MASK] = dur;
+  queueHead = head + 1; // publish the slot only after it's been written
+
+  // If the ISR ran out of tones before this one was published, it has
+  // already marked the channel as not playing, so it's restarted here.
+  if (ch.source != getNextQueued || !ch.playing) {
+    lockEngine();
+    ch.source = getNextQueued;
+    ch.noteIndexed = false;
+    ch.chained = NULL;
+    ch.queueDurNext = false;
+    startChannel(ch);
+    unlockEngine();
+  }
+
+  return true;
+}
+
+uint8_t ArduboyTones::freeSlots()
+{
+  return TONES_QUEUE_SIZE - (uint8_t)(queueHead - queueTail);
+}
+#endif
+
+void ArduboyTones::tonesStream(TonesStreamReader reader, uint16_t *buffer,
+                               uint16_t size, uint8_t channel)
+{
+  if (channel >= TONES_CHANNELS || size < 4) {
+    return;
+  }
+
+  ToneChannel &ch = channels[channel];
+
+  // The ISR mustn't read the buffer while it's refilled, so the old stream
+  // is stopped now rather than by a request
+  if (channels[streamChannel].source == getNextStreamed) {
+    lockEngine();
+    channels[streamChannel].playing = false;
+    channels[streamChannel].source = getNextProgmem;
+    unlockEngine();
+  }
+
+  streamReader = reader;
+  streamBuffer = buffer;
+  streamHalfSize = (size / 4) * 2;
+  streamChannel = channel;
+  streamRead = 0;
+  streamStalled = false;
+  streamOffset = 0;
+  streamEnded = false;
+  streamFull[0] = streamFull[1] = false;
+
+  // Prefetch both halves before playing, outside the lock so other channels
+  // play on while the storage is read
+  fillStreamHalf(0);
+  fillStreamHalf(1);
+  streamFillHalf = 0;
+
+  lockEngine();
+  flushRequest(channel);
+  ch.source = getNextStreamed;
+  ch.noteIndexed = false;
+  ch.chained = NULL;
+  startChannel(ch);
+  unlockEngine();
+}
+
+void ArduboyTones::streamFill()
+{
+  // Halves are played and refilled in the same alternating order
+  ToneChannel &ch = channels[streamChannel];
+
+  while (ch.source == getNextStreamed && ch.playing && !streamEnded &&
+         !streamFull[streamFillHalf]) {
+    fillStreamHalf(streamFillHalf);
+    streamFillHalf ^= 1;
+  }
+}
+
+uint32_t ArduboyTones::streamUnderruns(bool reset)
+{
+  uint32_t count = streamStalls;
+
+  if (reset) {
+    streamStalls = 0;
+  }
+  return count;
+}
+
+uint32_t ArduboyTones::droppedEdges(bool reset)
+{
+  uint32_t count = dacBusyDrops;
+
+  if (reset) {
+    dacBusyDrops = 0;
+  }
+  return count;
+}
+
+int8_t ArduboyTones::tonesScheduled(const uint16_t *tones, uint8_t priority,
+                                   uint8_t channelMask)
+{
+  int8_t voice = -1;
+  uint32_t length = sequenceLength(tones); // walked before taking the lock
+
+  // A flushed request can start a tone, so the voice is chosen with the
+  // engine locked. If there's none to take, unlocking leaves the sound
+  // playing exactly as it was.
+  lockEngine();
+
+  for (uint8_t i = 0; i < TONES_CHANNELS; i++) {
+    if (!(channelMask & (1 << i))) {
+      continue;
+    }
+    flushRequest(i); // so a requested sequence counts as playing
+    if (!channels[i].playing) { // a free channel is always used first
+      voice = i;
+      break;
+    }
+    if (channels[i].priority > priority) {
+      continue; // never steal from a higher priority
+    }
+    if (voice < 0 || betterVictim(channels[i], channels[voice])) {
+      voice = i;
+    }
+  }
+
+  if (voice >= 0) {
+    startSequence(voice, (uint16_t *)tones, true);
+
+    ToneChannel &ch = channels[voice];
+    ch.priority = priority;
+    if (length != UINT32_MAX) {
+#if SAMPLE_ENGINE
+      ch.clockEnd = ((uint64_t)length * DURATION_SAMPLES_X1024) >> 10;
+#else
+      ch.clockEnd = (uint64_t)length * DURATION_CLOCK;
+#endif
+    }
+  }
+
+  unlockEngine();
+  return voice;
+}
+
+void ArduboyTones::setEffects(const uint16_t * const *effects,
+                              uint8_t count)
+{
+  holdEngine();
+  effectTable = effects;
+  effectCount = count;
+  triggerSeen = triggerCmd; // drop any trigger for the old table
+  releaseEngine();
+}
+
+void ArduboyTones::trigger(uint8_t effect, uint16_t pitch)
+{
+  if (effect >= effectCount) {
+    return;
+  }
+
+  // Post the command. The ISR picks it up at its next interrupt.
+  triggerCmd = ((uint32_t)pitch << 16) | (effect << 8) | ++triggerNum;
+
+  // The command must be posted first. If the engine stops after this check,
+  // the ISR has already seen the command.
+  if (!engineRunning()) {
+    lockEngine();
+    pickUpTrigger();
+    unlockEngine();
+  }
+}
+
+uint32_t ArduboyTones::tunedFrequency(uint32_t freq)
+{
+#if SAMPLE_ENGINE
+  // The phase step times the actual sample rate, in 1/16 Hz
+  return ((uint64_t)FINE_PHASE_STEP(freq) * (F_CPU / (SAMPLE_TIMER_COUNT + 1))
+          + (1UL << 27)) >> 28;
+#else
+  uint32_t halfPeriod;
+  uint32_t tickRate = F_CPU / 16;
+
+  if (freq == 0) {
+    return 0;
+  }
+
+  // The same half cycle nextTone() sets up, averaged over the dithering
+  halfPeriod = HALF_PERIOD_FINE / freq;
+  if (halfPeriod >= (0x10000UL << 8)) {
+    halfPeriod = (halfPeriod >> 4) << 4; // the clk/256 count's precision
+  }
+  return (((uint64_t)tickRate << 11) + halfPeriod / 2) / halfPeriod;
+#endif
+}
+
+uint32_t ArduboyTones::sequenceTime()
+{
+  return sequenceTime(0);
+}
+
+uint32_t ArduboyTones::sequenceTime(uint8_t channel)
+{
+  uint64_t clock;
+  uint32_t primask;
+
+  if (channel >= TONES_CHANNELS) {
+    return 0;
+  }
+
+  // The ISR updates the clock, so take a consistent copy
+  primask = __get_PRIMASK();
+  __disable_irq();
+  clock = channels[channel].clock;
+  __set_PRIMASK(primask);
+
+#if SAMPLE_ENGINE
+  return clock * 1024 / DURATION_SAMPLES_X1024;
+#else
+  return clock / DURATION_CLOCK;
+#endif
+}
+
+#if TONES_CUE_QUEUE_SIZE > 0
+bool ArduboyTones::readCue(TonesCue &cue)
+{
+  uint8_t tail = cueTail;
+
+  if (tail == cueHead) {
+    return false;
+  }
+
+  cue.id = cueIds[tail & CUE_MASK];
+  cue.channel = cueChannels[tail & CUE_MASK];
+  cueTail = tail + 1; // the slot is free once it's been read
+  return true;
+}
+
+#if TONES_CUE_PENDSV
+void ArduboyTones::setCueCallback(void (*callback)())
+{
+  cueCallback = callback;
+}
+
+// Made pending by the ISR when a cue event is queued. At the lowest
+// priority, so the callback runs with the audio interrupt free to preempt it.
+void PendSV_Handler()
+{
+  void (*callback)() = cueCallback;
+
+  if (callback != NULL) {
+    callback();
+  }
+}
+#endif
+#endif
+
+#if TONES_STATS
+TonesStats ArduboyTones::stats(bool reset)
+{
+  TonesStats result;
+  unsigned long now = millis();
+  uint32_t primask = __get_PRIMASK();
+
+  // Take a consistent copy, as the ISR updates the values
+  __disable_irq();
+  result = statsData;
+  result.dacBusy = dacBusyDrops;
+  if (reset) {
+    memset(&statsData, 0, sizeof(statsData));
+    dacBusyDrops = 0;
+  }
+  __set_PRIMASK(primask);
+
+  result.elapsedMs = now - statsStart;
+  result.interruptsPerSecond = 0;
+  if (result.elapsedMs != 0) {
+    result.interruptsPerSecond =
+      (uint64_t)result.interrupts * 1000 / result.elapsedMs;
+  }
+
+  if (reset) {
+    statsStart = now;
+  }
+  return result;
+}
+#endif
+
+#if SAMPLE_ENGINE
+void ArduboyTones::nextTone()
+{
+  nextChannelTone(channels[0]);
+}
+
+void ArduboyTones::fillBuffer(uint16_t *buf, uint16_t count)
+{
+  for (uint16_t i = 0; i < count; i++) {
+    buf[i] = 0;
+  }
+
+  for (uint8_t i = 0; i < TONES_CHANNELS; i++) {
+    mixChannel(channels[i], buf, count);
+  }
+
+#if TONES_PCM
+  mixSample(buf, count);
+#endif
+}
+#else
+#if TONES_POWER_SAVE || HARDWARE_TONES
+// Time a note that doesn't need the timer to make its edges, in as few
+// interrupts as possible
+static void timeWholeNote(ToneChannel &ch)
+{
+  uint32_t ticks = 1;
+  uint32_t periods;
+
+  if (ch.noteEnd > ch.clock) {
+    ticks = (ch.noteEnd - ch.clock + (1UL << CLOCK_SHIFT_DIV1024) - 1)
+            >> CLOCK_SHIFT_DIV1024;
+  }
+  // Split evenly to fit 16 bit compares, rounding the periods up so the
+  // last one doesn't fall just short of the end
+  periods = ((ticks - 1) >> 16) + 1;
+  if (periods > 1) {
+    ticks = (ticks + periods - 1) / periods;
+  }
+  ch.clockStep = (uint64_t)ticks << CLOCK_SHIFT_DIV1024;
+  ch.periodFrac = 0;
+  startTimer(ticks - 1, TC_CTRLA_PRESCALER_DIV1024);
 }
+#endif
 
 void ArduboyTones::nextTone()
 {
+  ToneChannel &ch = channels[0];
   uint16_t freq;
   uint16_t dur;
-  long toggleCount;
-  uint32_t timerCount;
+  uint32_t fine;
+  uint32_t halfPeriod;
+  uint32_t prescaler;
+
+  freq = readEffects(ch, getNext(ch)); // get tone frequency
 
-  freq = getNext(); // get tone frequency
+  // A chained sequence takes over from an end or repeat marker, so the
+  // transition is seamless
+  if ((freq == TONES_END || freq == TONES_REPEAT) && ch.chained != NULL) {
+    freq = readEffects(ch, chainSequence(ch));
+  }
 
   if (freq == TONES_END) { // if freq is actually an "end of sequence" marker
-    noTone(); // stop playing
+    // stop playing, without flushing what the foreground may be enqueuing
+    stopTimer();
+    outputSilence();
+    ch.playing = false;
+    postEndCue(ch);
     return;
   }
 
-  tonesPlaying = true;
+  ch.playing = true;
 
   if (freq == TONES_REPEAT) { // if frequency is actually a "repeat" marker
-    tonesIndex = tonesStart; // reset to start of sequence
-    freq = getNext();
+    ch.index = ch.start; // reset to start of sequence
+    freq = readEffects(ch, getNext(ch));
   }
 
   if (((freq & TONE_HIGH_VOLUME) || forceHighVol) && !forceNormVol) {
-    toneHighVol = true;
+    ch.highVol = true;
   }
   else {
-    toneHighVol = false;
+    ch.highVol = false;
   }
+  updateAmp(ch);
 
   freq &= ~TONE_HIGH_VOLUME; // strip volume indicator from frequency
 
-  if (freq == 0) { // if tone is silent
-    timerCount = F_CPU / 16 / SILENT_FREQ / 2 - 1; // dummy tone for silence
-    freq = SILENT_FREQ;
-    toneSilent = true;
+  if (ch.pitch != TONES_PITCH_NORMAL && !ch.noteIndexed) {
+    freq = scalePitch(freq, ch.pitch);
+  }
+
+  fine = ch.fineFreq; // only for the tone started by toneFine()
+  ch.fineFreq = 0;
+
+  if (ch.noteIndexed) { // precomputed values, so no divide needed
+    if (freq >= NOTE_INDEX_COUNT) {
+      freq = NOTE_INDEX_REST;
+    }
+    halfPeriod = noteHalfPeriods[freq];
+    ch.silent = (freq == NOTE_INDEX_REST);
+  }
+  else if (fine != 0) {
+    halfPeriod = HALF_PERIOD_FINE / fine;
+    ch.silent = false;
+  }
+  else if (freq == 0) { // if tone is silent
+    halfPeriod = SILENT_HALF_PERIOD; // dummy tone for silence
+    ch.silent = true;
   }
   else {
-    timerCount = F_CPU / 16 / freq / 2 - 1;
-    toneSilent = false;
+    halfPeriod = HALF_PERIOD_HZ / freq;
+    ch.silent = false;
   }
 
-  if (!outputEnabled()) { // if sound has been muted
-    toneSilent = true;
+  if (!soundOn()) { // if sound has been muted
+    ch.silent = true;
   }
 
-  dur = getNext(); // get tone duration
+  dur = getNext(ch); // get tone duration
   if (dur != 0) {
-    // A right shift is used to divide by 512 for efficency.
-    // For durations in milliseconds it should actually be a divide by 500,
-    // so durations will by shorter by 2.34% of what is specified.
-    toggleCount = ((long)dur * freq) >> 9;
+    // Durations are timed against the timer clock, not counted in waveform
+    // toggles. A tone ends at the interrupt which reaches its end time, and
+    // the next tone's end time follows on from the exact end of this one, so
+    // no error builds up over a sequence.
+    ch.noteEnd += (uint64_t)dur * DURATION_CLOCK;
+  }
+  else {
+    ch.noteEnd = UINT64_MAX; // indicate infinite duration
+  }
+
+#if HARDWARE_TONES
+  // The TCC plays the tone by itself, so the timer only times the note, or
+  // is stopped if it lasts until the next tone or noTone()
+  if (ch.silent) {
+    outputSilence();
+  }
+  else {
+    outputTone(halfPeriod, ch.amp);
+  }
+  if (dur == 0) {
+    stopTimer();
+  }
+  else {
+    timeWholeNote(ch);
+  }
+  return;
+#endif
+
+#if TONES_POWER_SAVE
+  if (ch.silent) {
+    // Time the rest in as few interrupts as possible instead of toggling
+    // silently, or not at all if it lasts until the next tone or noTone()
+    if (dur == 0) {
+      stopTimer();
+    }
+    else {
+      timeWholeNote(ch);
+    }
+    return;
+  }
+#endif
+
+  // Set counter based on desired frequency. Below about 57 Hz the count,
+  // with a tick added by the dithering, doesn't fit in 16 bits at clk/16,
+  // so clk/256 is used.
+  if (halfPeriod >= (0x10000UL << 8)) {
+    halfPeriod >>= 4;
+    ch.clockShift = CLOCK_SHIFT_DIV256;
+    prescaler = TC_CTRLA_PRESCALER_DIV256;
   }
   else {
-    toggleCount = -1; // indicate infinite duration
+    ch.clockShift = CLOCK_SHIFT_DIV16;
+    prescaler = TC_CTRLA_PRESCALER_DIV16;
   }
+  ch.periodCount = (halfPeriod >> 8) - 1;
+  ch.periodFrac = halfPeriod & 0xFF;
+  ch.periodAcc = 0;
+  ch.clockStep = (uint64_t)(ch.periodCount + 1) << ch.clockShift;
+  startTimer(ch.periodCount, prescaler);
+}
 
-  durationToggleCount = toggleCount;
+// Set the length of the half cycle that has just started. It's a tick
+// longer each time the fraction carries, so its average is exact. The
+// compare value is written without a sync wait, well before the count
+// reaches it.
+static inline void ditherPeriod(ToneChannel &ch)
+{
+  uint16_t acc = ch.periodAcc + ch.periodFrac;
+  uint32_t count = ch.periodCount + (acc >> 8);
 
-  // Set counter based on desired frequency
-  TIMER_CTRL->COUNT16.CC[0].reg = timerCount;
-  enable_counter(true);
+  ch.periodAcc = acc;
+  timerSetCount(count);
+  ch.clockStep = (uint64_t)(count + 1) << ch.clockShift;
 }
+#endif
 
-uint16_t ArduboyTones::getNext()
+#if TONES_ENGINE == TONES_ENGINE_DMA
+TONES_DMA_HANDLER
 {
-  if (inProgmem) {
-    return pgm_read_word(tonesIndex++);
+  uint16_t *half;
+  STATS_ISR_BEGIN
+
+  DMAC->Channel[TONES_DMA_CHANNEL].CHINTFLAG.reg = DMAC_CHINTFLAG_TCMPL;
+
+  // Rendered into the half refilled below
+  pickUpRequests();
+  pickUpTrigger();
+
+  // Stop once both halves have been filled with silence and played out
+  if (!anySound()) {
+    if (++dmaIdleBlocks > 2) {
+      stopEngine();
+      STATS_ISR_END
+      return;
+    }
+  }
+  else {
+    dmaIdleBlocks = 0;
+  }
+
+  // The half that just completed is refilled while the other one plays
+  half = dmaNextHalf ? dmaBuffer + DMA_HALF_SIZE : dmaBuffer;
+  dmaNextHalf ^= 1;
+  ArduboyTones::fillBuffer(half, DMA_HALF_SIZE);
+  outputConvert(half, DMA_HALF_SIZE);
+  STATS_ISR_END
+}
+#elif TONES_ENGINE == TONES_ENGINE_FIXED_RATE
+// Play one sample, from the timer interrupt or the sketch's shared tick
+static inline void sampleTick()
+{
+  uint16_t sample;
+  STATS_ISR_BEGIN
+
+  pickUpRequests();
+  pickUpTrigger();
+
+  // Note changes only load a new phase step, the timer is never touched
+  ArduboyTones::fillBuffer(&sample, 1);
+
+#if !TONES_HOST // offline rendering only uses fillBuffer()
+  if (outputActive()) {
+    // Never wait for the DAC. If it isn't ready the sample is dropped.
+    if (outputReady()) {
+      outputWrite(sample);
+    }
+    else {
+      dacBusyDrops++;
+    }
+  }
+#endif
+
+  if (!anySound()) {
+    timerStopFromISR();
+#if TONES_POWER_SAVE
+    sleepOutput();
+#endif
+  }
+  STATS_ISR_END
+}
+
+#if TONES_TIMER == TONES_TIMER_SHARED
+void ArduboyTones::tick()
+{
+  if (tickEnabled) {
+    sampleTick();
   }
-  return *tonesIndex++;
 }
+#else
+TIMER_HANDLER
+{
+  sampleTick();
 
+  // Clear the interrupt
+  timerClearInterrupt();
+}
+#endif
+#else
 volatile bool val;
 TIMER_HANDLER
 {
-  if (durationToggleCount != 0) {
-    if (!toneSilent) {
-      if (!DAC->DACCTRL[DAC_CH_SPEAKER].bit.ENABLE)
-        return;
+  ToneChannel &ch = channels[0];
+  bool matched = timerMatched(); // else made pending by publishRequest()
+  bool started;
+  STATS_ISR_BEGIN
 
-      while (!DAC_READY);
-      while (DAC_DATA_BUSY);
-      val = !val;
-      DAC->DATA[DAC_CH_SPEAKER].reg = val ? 0 : (toneHighVol ? 4095 : 3072);
-    }
+  // Clear the interrupt straight away, so a match during the work below
+  // raises it again instead of being lost
+  timerClearInterrupt();
+
+  if (matched) {
+    ch.clock += ch.clockStep;
+  }
 
-    if (durationToggleCount > 0) {
-      durationToggleCount--;
+  // A new sequence or trigger() effect takes over at this interrupt
+  started = pickUpRequests();
+  started |= pickUpTrigger();
+  if (started) {
+    // Part way through a count, so start the new tone's first half cycle
+    // from 0
+    if (!matched && timerEnabled()) {
+      timerRetrigger();
+      timerClearInterrupt(); // a match just before belonged to the old tone
     }
   }
-  else {
-    ArduboyTones::nextTone();
+  else if (matched) {
+    if (ch.clock < ch.noteEnd) {
+#if !HARDWARE_TONES // the TCC makes the edges, this only times the note
+      if (!ch.silent && outputActive()) {
+        // Never wait for the DAC. If it isn't ready the edge is dropped, but
+        // the level still toggles so the following edge is back in phase.
+        val = !val;
+        if (outputReady()) {
+          outputWrite(val ? 0 : ch.amp);
+        }
+        else {
+          dacBusyDrops++;
+        }
+      }
+      if (ch.periodFrac != 0) {
+        ditherPeriod(ch);
+      }
+#endif
+    }
+    else {
+      timedNextTone(ch);
+    }
   }
 
-  // Clear the interrupt
-  TIMER_CTRL->COUNT16.INTFLAG.bit.MC0 = 1;
+  STATS_ISR_END
 }
+#endif
@@ -29,6 +29,234 @@
  */
 #define TONE_HIGH_VOLUME 0x8000
 
+/** \brief
+ * Convert a frequency in hertz, which may have a fraction, to the 1/16 Hz
+ * units used by `toneFine()`.
+ */
+#define TONES_FINE_HZ(hz) ((uint32_t)((hz) * 16 + 0.5))
+
+/** \brief
+ * `trigger()` pitch value to play an effect at the frequencies it was
+ * written with. The pitch is 8.8 fixed point, so 512 is an octave up and 128
+ * an octave down.
+ */
+#define TONES_PITCH_NORMAL 0x100
+
+/** \brief
+ * `setVolume()` parameter. The highest volume level, the default. Level 0
+ * is silent and each level in between is 3 dB lower than the next.
+ */
+#define TONES_VOLUME_MAX 15
+
+/** \brief
+ * `setWaveform()` parameter. The original square wave, the default. It
+ * needs no wavetable but aliases at high pitches.
+ */
+#define TONES_WAVE_SQUARE 0
+
+/** \brief
+ * `setWaveform()` parameter. A band limited square wave, from a table with
+ * as many harmonics as fit below half the sample rate for the pitch.
+ */
+#define TONES_WAVE_SQUARE_BL 1
+
+/** \brief
+ * `setWaveform()` parameter. A triangle wave.
+ */
+#define TONES_WAVE_TRIANGLE 2
+
+/** \brief
+ * `setWaveform()` parameter. A band limited sawtooth wave.
+ */
+#define TONES_WAVE_SAW 3
+
+/** \brief
+ * `setWaveform()` parameter. Noise from a shift register clocked at the
+ * tone's frequency, so higher frequencies give brighter noise.
+ */
+#define TONES_WAVE_NOISE 4
+
+/** \brief
+ * `setWaveform()` parameter. A sine wave.
+ */
+#define TONES_WAVE_SINE 5
+
+/** \brief
+ * `playSample()` format. Unsigned 8 bit PCM, one byte per sample, as stored
+ * in 8 bit WAV files.
+ */
+#define TONES_PCM_8BIT 0
+
+/** \brief
+ * `playSample()` format. 4 bit IMA ADPCM, two samples per byte with the
+ * first in the low 4 bits, starting from a level of 0 and a step index of
+ * 0. Made by `extras/pcm2tones.py`.
+ */
+#define TONES_PCM_ADPCM 1
+
+/** \brief
+ * `tonesScheduled()` channel mask allowing any channel to be used
+ */
+#define TONES_ALL_CHANNELS 0xFF
+
+// ***** Packed sequences for tonesPacked() *****
+
+/** \brief
+ * Packed sequence note value for sequence termination. (No duration follows)
+ */
+#define TONES_PACKED_END 0x7F
+
+/** \brief
+ * Packed sequence note value for sequence repeat. (No duration follows)
+ */
+#define TONES_PACKED_REPEAT 0x7E
+
+/** \brief
+ * Add this to a packed sequence note index to play it at high volume
+ */
+#define TONES_PACKED_HIGH_VOLUME 0x80
+
+/** \brief
+ * A packed sequence tempo table entry: a duration in 1024ths of a second.
+ */
+#define TONES_PACKED_DURATION(dur) ((dur) & 0xFF), (((dur) >> 8) & 0xFF)
+
+/** \brief
+ * A packed sequence event: a note index played for the duration given by
+ * entry `code` (0 to 15) of the tempo table.
+ */
+#define TONES_PACKED_NOTE(note, code) (note), (code)
+
+/** \brief
+ * A packed sequence event repeated `count` times (1 to 16) in a row. Most
+ * useful for long rests, which would otherwise need an event per beat.
+ */
+#define TONES_PACKED_RUN(note, code, count) \
+  (note), ((((count) - 1) << 4) | (code))
+
+// ***** Pattern songs for tonesPatterns() *****
+
+/** \brief
+ * Order list value ending a channel's list. The channel stops.
+ */
+#define TONES_ORDER_END 0xFF
+
+/** \brief
+ * Order list value ending a channel's list. The list repeats from its
+ * start.
+ */
+#define TONES_ORDER_REPEAT 0xFE
+
+/** \brief
+ * Order list entry ending a channel's list. The list repeats from
+ * `position`, counted from 0 at the start of the channel's list, so an
+ * introduction can be played once before the part that loops.
+ */
+#define TONES_ORDER_LOOP(position) 0xFD, (position)
+
+// ***** Note effects *****
+
+/** \brief
+ * Sequence values from this up are effect commands, each followed by one
+ * parameter value in place of a duration. The commands apply to the tone
+ * that follows them. Frequencies from 30720 Hz up, with high volume, can't
+ * be used.
+ */
+#define TONES_FX_FIRST 0xF800
+
+// Effect command values, used by the macros below
+#define TONES_FX_ATTACK   0xF800
+#define TONES_FX_DECAY    0xF900
+#define TONES_FX_RELEASE  0xFA00
+#define TONES_FX_SLIDE    0xFB00
+#define TONES_FX_SWEEP    0xFC00
+#define TONES_FX_VIBRATO  0xFD00
+#define TONES_FX_ARPEGGIO 0xFE00
+
+// A time in milliseconds, as a number of note effect control ticks
+#define TONES_FX_TICKS(ms) \
+  ((uint16_t)((uint32_t)(ms) * TONES_CONTROL_RATE / 1000))
+
+/** \brief
+ * Effect command. The next tone fades in from silence over `ms`
+ * milliseconds.
+ */
+#define TONES_ATTACK(ms) TONES_FX_ATTACK, TONES_FX_TICKS(ms)
+
+/** \brief
+ * Effect command. After its attack, the next tone fades over `ms`
+ * milliseconds to the `sustain` level, from 0 (silent) to 255 (full
+ * volume).
+ */
+#define TONES_DECAY(ms, sustain) \
+  (TONES_FX_DECAY | ((sustain) & 0xFF)), TONES_FX_TICKS(ms)
+
+/** \brief
+ * Effect command. The next tone fades out over the last `ms` milliseconds
+ * of its duration.
+ */
+#define TONES_RELEASE(ms) TONES_FX_RELEASE, TONES_FX_TICKS(ms)
+
+/** \brief
+ * Effect commands giving the next tone a complete attack, decay, sustain
+ * and release envelope. See `TONES_ATTACK()`, `TONES_DECAY()` and
+ * `TONES_RELEASE()`.
+ */
+#define TONES_ENVELOPE(attack, decay, sustain, release) \
+  TONES_ATTACK(attack), TONES_DECAY(decay, sustain), TONES_RELEASE(release)
+
+/** \brief
+ * Effect command. The pitch of the next tone slides linearly to `target`
+ * over its duration. `target` is a frequency, or a `NOTE_INDEX_*` value in
+ * a `noteTones()` sequence.
+ */
+#define TONES_SLIDE(target) TONES_FX_SLIDE, (target)
+
+/** \brief
+ * Effect command. The pitch of the next tone changes exponentially by
+ * `semitonesPerSecond`, which is negative to fall, with a resolution of
+ * 1/16 semitone per second.
+ */
+#define TONES_SWEEP(semitonesPerSecond) \
+  TONES_FX_SWEEP, ((uint16_t)(int16_t)((semitonesPerSecond) * 16))
+
+/** \brief
+ * Effect command. The pitch of the next tone rises and falls by up to
+ * `cents` (up to 255) hundredths of a semitone, `hz` times a second.
+ */
+#define TONES_VIBRATO(cents, hz) \
+  (TONES_FX_VIBRATO | ((cents) & 0xFF)), \
+  ((uint16_t)(TONES_CONTROL_RATE / (4.0 * (hz)) + 0.5))
+
+/** \brief
+ * Effect command. The next tone cycles between its own pitch and the notes
+ * `semi1` and `semi2` (each 0 to 15) semitones above it, changing every
+ * `ms` milliseconds.
+ */
+#define TONES_ARPEGGIO(semi1, semi2, ms) \
+  (TONES_FX_ARPEGGIO | (((semi1) & 0xF) << 4) | ((semi2) & 0xF)), \
+  TONES_FX_TICKS(ms)
+
+// ***** Cue markers *****
+
+// Cue marker command value. Cues are read whether or not TONES_NOTE_EFFECTS
+// is enabled.
+#define TONES_FX_CUE 0xFF00
+
+/** \brief
+ * A cue marker, placed between the tones of a sequence. When the sequence
+ * reaches it, an event with `id` (0 to 65534) is queued for `readCue()`.
+ * It takes no time.
+ */
+#define TONES_CUE(id) TONES_FX_CUE, (id)
+
+/** \brief
+ * The id of the cue event queued when a channel's sequence reaches its
+ * `TONES_END`, if the sequence had any cue markers. Not queued for
+ * sequences without them, or stopped by `noTone()`.
+ */
+#define TONES_CUE_END 0xFFFF
+
 
 /** \brief
  * `volumeMode()` parameter. Use the volume encoded in each tone's frequency
@@ -47,25 +275,448 @@
  */
 #define VOLUME_ALWAYS_HIGH 2
 
-// This must match the maximum number of tones that can be specified in
-// the tone() function.
+// The maximum number of tones that can be given to the tone() function.
+// Each of the library's tone() buffers holds this many, so every 1 added
+// costs 4 bytes of RAM for each of them (TONES_CHANNELS + 3 buffers).
+// Define this in the build flags to override.
+#ifndef MAX_TONES
 #define MAX_TONES 3
+#endif
+
+#if MAX_TONES < 3 || MAX_TONES > 32
+#error "MAX_TONES must be from 3 to 32"
+#endif
 
 #define PIN_SPEAKER    PIN_DAC1
 #define DAC_CH_SPEAKER 1
 #define DAC_READY      DAC->STATUS.bit.READY1
 #define DAC_DATA_BUSY  DAC->SYNCBUSY.bit.DATA1
 
-// Change these if there's a conflict with timers between this library
-// and others
-#define TIMER_CTRL    TC3
-#define TIMER_GCLK_ID TC3_GCLK_ID
-#define TIMER_IRQ     TC3_IRQn
-#define TIMER_HANDLER void TC3_Handler()
-
 // Dummy frequency used to for silent tones (rests).
 #define SILENT_FREQ 25
 
+// Number of frequency/duration pairs the enqueue() ring buffer holds. Must be
+// a power of 2, up to 128, or 0 to remove the queue and save its RAM.
+#ifndef TONES_QUEUE_SIZE
+#define TONES_QUEUE_SIZE 16
+#endif
+
+// The channel the enqueue() ring buffer plays on
+#ifndef TONES_QUEUE_CHANNEL
+#define TONES_QUEUE_CHANNEL 0
+#endif
+
+// Number of cue events the readCue() queue holds. Must be a power of 2, up
+// to 128, or 0 to skip TONES_CUE() markers and save the queue's RAM.
+#ifndef TONES_CUE_QUEUE_SIZE
+#define TONES_CUE_QUEUE_SIZE 8
+#endif
+
+// Set to 1 to call the setCueCallback() function from the PendSV exception,
+// at the lowest priority, each time a cue event is queued. The library then
+// defines PendSV_Handler(), so this can't be used with an RTOS that needs it.
+#ifndef TONES_CUE_PENDSV
+#define TONES_CUE_PENDSV 0
+#endif
+
+// Default NVIC priority of the audio interrupt, from 0 (highest) to 7
+// (lowest). Can also be set using the constructor.
+#ifndef TONES_IRQ_PRIORITY
+#define TONES_IRQ_PRIORITY 0
+#endif
+
+// Set to 1 for durations, and sequenceTime(), in milliseconds instead of
+// 1024ths of a second. The units are exact either way.
+#ifndef TONES_DURATION_MS
+#define TONES_DURATION_MS 0
+#endif
+
+// Set to 1 to save power while idle. The timer's clock is removed whenever
+// nothing is playing, and the edge engine times rests with one compare
+// interrupt (or a few for rests over about half a second) instead of
+// silently toggling at SILENT_FREQ. Rests of infinite duration stop the
+// timer altogether.
+#ifndef TONES_POWER_SAVE
+#define TONES_POWER_SAVE 0
+#endif
+
+// Set to 1, along with TONES_POWER_SAVE, to also disable the DAC while
+// nothing is playing. This turns off both DAC channels, so only use it if
+// nothing else uses the DAC. The DAC needs time to start up again, so the
+// first few edges or samples of the next sound may be lost.
+#ifndef TONES_DAC_POWER_DOWN
+#define TONES_DAC_POWER_DOWN 0
+#endif
+
+// Set to 1 to build the library for a desktop computer instead, to render
+// sequences offline with extras/host/tones2wav.cpp. Only the fixed rate
+// engine's sequencing and synthesis are built. No hardware is touched and
+// samples are pulled using fillBuffer().
+#ifndef TONES_HOST
+#define TONES_HOST 0
+#endif
+
+// ************************************************************
+// ***** Playback engine selection *****
+// ************************************************************
+
+/** \brief
+ * `TONES_ENGINE` value. The timer interrupts on every waveform edge and the
+ * ISR writes each edge to the DAC.
+ */
+#define TONES_ENGINE_EDGE 0
+
+/** \brief
+ * `TONES_ENGINE` value. The timer runs at a fixed `TONES_SAMPLE_RATE` and
+ * paces a DMAC channel which streams a double buffer of precomputed samples
+ * into the DAC. The CPU is only interrupted when a buffer half completes.
+ */
+#define TONES_ENGINE_DMA 1
+
+/** \brief
+ * `TONES_ENGINE` value. The timer interrupts at a fixed `TONES_SAMPLE_RATE`
+ * and the ISR writes one synthesized sample to the DAC each time. Tones are
+ * generated by phase accumulators, so changing notes never reprograms the
+ * timer. Uses no DMA channel.
+ */
+#define TONES_ENGINE_FIXED_RATE 2
+
+// The playback engine to use. Define this in the build flags to override.
+#ifndef TONES_ENGINE
+#define TONES_ENGINE TONES_ENGINE_EDGE
+#endif
+
+// Sample rate for the sample based engines, in hertz. For exact timing,
+// F_CPU should be a multiple of this. With TONES_OUTPUT_I2S the default is
+// one the I2S clock can divide down to exactly.
+#ifndef TONES_SAMPLE_RATE
+#if defined(TONES_OUTPUT) && TONES_OUTPUT == 2 // TONES_OUTPUT_I2S
+#define TONES_SAMPLE_RATE 31250
+#else
+#define TONES_SAMPLE_RATE 32000
+#endif
+#endif
+
+// Total number of samples in the DMA double buffer (both halves). Each half
+// is rendered in a single interrupt, so this sets both the interrupt rate and
+// the latency of a new tone.
+#ifndef TONES_DMA_BUFFER_SIZE
+#define TONES_DMA_BUFFER_SIZE 256
+#endif
+
+// Number of independent channels mixed by the sample based engines
+// (TONES_ENGINE_DMA and TONES_ENGINE_FIXED_RATE), from 1 to 4. The edge
+// engine only supports 1.
+#ifndef TONES_CHANNELS
+#define TONES_CHANNELS 1
+#endif
+
+// Set to 1 to add the setWaveform() wavetables (about 3.3 KB of flash).
+// Only for the sample based engines.
+#ifndef TONES_WAVETABLES
+#define TONES_WAVETABLES 0
+#endif
+
+// Set to 1 to add a voice playing PCM or ADPCM samples with playSample(),
+// mixed with the tone channels. Only for the sample based engines. The
+// voice takes its share of the output level, as a channel does.
+#ifndef TONES_PCM
+#define TONES_PCM 0
+#endif
+
+// Set to 1 to play the note effects given by commands such as
+// TONES_ENVELOPE() and TONES_SLIDE() in sequences. Only for the sample based
+// engines. When 0, the commands are skipped, so the notes play without them.
+#ifndef TONES_NOTE_EFFECTS
+#define TONES_NOTE_EFFECTS 0
+#endif
+
+// Rate at which note effects are updated, in hertz. Effect times are whole
+// numbers of these control ticks. TONES_SAMPLE_RATE should be a multiple.
+#ifndef TONES_CONTROL_RATE
+#define TONES_CONTROL_RATE 1000
+#endif
+
+// The channel trigger() effects play on. By default the last one, so with
+// the mixer, music on channel 0 isn't cut off.
+#ifndef TONES_EFFECT_CHANNEL
+#define TONES_EFFECT_CHANNEL (TONES_CHANNELS - 1)
+#endif
+
+// Change these if there's a conflict with DMA channels between this library
+// and others
+#define TONES_DMA_CHANNEL  3
+#define TONES_DMA_IRQ      DMAC_3_IRQn
+#define TONES_DMA_HANDLER  void DMAC_3_Handler()
+
+// ************************************************************
+// ***** Timer selection *****
+// ************************************************************
+
+/** \brief
+ * `TONES_TIMER` value. Use TC3, the default. TC3 shares a clock channel
+ * with TC2, so with `TONES_POWER_SAVE` TC2 mustn't be in use.
+ */
+#define TONES_TIMER_TC3 0
+
+/** \brief
+ * `TONES_TIMER` value. Use TC4. TC4 and TC5 share a clock channel, so with
+ * `TONES_POWER_SAVE` the other one mustn't be in use.
+ */
+#define TONES_TIMER_TC4 1
+
+/** \brief
+ * `TONES_TIMER` value. Use TC5. See `TONES_TIMER_TC4`.
+ */
+#define TONES_TIMER_TC5 2
+
+/** \brief
+ * `TONES_TIMER` value. Use TCC0, running as a plain counter. TCC0 and TCC1
+ * share a clock channel, so with `TONES_POWER_SAVE` the other one mustn't be
+ * in use.
+ */
+#define TONES_TIMER_TCC0 3
+
+/** \brief
+ * `TONES_TIMER` value. Use TCC1. See `TONES_TIMER_TCC0`.
+ */
+#define TONES_TIMER_TCC1 4
+
+/** \brief
+ * `TONES_TIMER` value. Use no timer of its own. The sketch calls
+ * `ArduboyTones::tick()` at `TONES_SAMPLE_RATE` from an interrupt it owns,
+ * which can also run other periodic work, such as polling buttons, every so
+ * many ticks. Only for `TONES_ENGINE_FIXED_RATE`. `TONES_TICK_IRQ` must be
+ * defined as the interrupt tick() is called from, so the library can hold it
+ * off while changing what's playing.
+ */
+#define TONES_TIMER_SHARED 5
+
+// The timer to use. Define this in the build flags to override, if there's
+// a conflict with timers between this library and others.
+#ifndef TONES_TIMER
+#if TONES_HOST
+#define TONES_TIMER TONES_TIMER_SHARED
+#define TONES_TICK_IRQ 0 // nothing to disable
+#else
+#define TONES_TIMER TONES_TIMER_TC3
+#endif
+#endif
+
+#if TONES_TIMER == TONES_TIMER_TC3
+#define TIMER_CTRL         TC3
+#define TIMER_GCLK_ID      TC3_GCLK_ID
+#define TIMER_IRQ          TC3_IRQn
+#define TIMER_HANDLER      void TC3_Handler()
+#define TIMER_DMAC_TRIGGER TC3_DMAC_ID_OVF
+#elif TONES_TIMER == TONES_TIMER_TC4
+#define TIMER_CTRL         TC4
+#define TIMER_GCLK_ID      TC4_GCLK_ID
+#define TIMER_IRQ          TC4_IRQn
+#define TIMER_HANDLER      void TC4_Handler()
+#define TIMER_DMAC_TRIGGER TC4_DMAC_ID_OVF
+#elif TONES_TIMER == TONES_TIMER_TC5
+#define TIMER_CTRL         TC5
+#define TIMER_GCLK_ID      TC5_GCLK_ID
+#define TIMER_IRQ          TC5_IRQn
+#define TIMER_HANDLER      void TC5_Handler()
+#define TIMER_DMAC_TRIGGER TC5_DMAC_ID_OVF
+#elif TONES_TIMER == TONES_TIMER_TCC0
+#define TIMER_CTRL         TCC0
+#define TIMER_GCLK_ID      TCC0_GCLK_ID
+#define TIMER_IRQ          TCC0_1_IRQn // the MC0 interrupt
+#define TIMER_HANDLER      void TCC0_1_Handler()
+#define TIMER_DMAC_TRIGGER TCC0_DMAC_ID_OVF
+#elif TONES_TIMER == TONES_TIMER_TCC1
+#define TIMER_CTRL         TCC1
+#define TIMER_GCLK_ID      TCC1_GCLK_ID
+#define TIMER_IRQ          TCC1_1_IRQn // the MC0 interrupt
+#define TIMER_HANDLER      void TCC1_1_Handler()
+#define TIMER_DMAC_TRIGGER TCC1_DMAC_ID_OVF
+#elif TONES_TIMER == TONES_TIMER_SHARED
+#ifndef TONES_TICK_IRQ
+#error "TONES_TIMER_SHARED needs TONES_TICK_IRQ, the interrupt tick() is called from"
+#endif
+#define TIMER_IRQ TONES_TICK_IRQ
+#else
+#error "Unknown TONES_TIMER"
+#endif
+
+// The timer is a TCC, rather than a TC, so its registers are laid out
+// differently
+#define TIMER_IS_TCC \
+  (TONES_TIMER == TONES_TIMER_TCC0 || TONES_TIMER == TONES_TIMER_TCC1)
+
+// ************************************************************
+// ***** Output selection *****
+// ************************************************************
+
+/** \brief
+ * `TONES_OUTPUT` value. Write levels to DAC channel 1 (`PIN_DAC1`), the
+ * default.
+ */
+#define TONES_OUTPUT_DAC 0
+
+/** \brief
+ * `TONES_OUTPUT` value. Drive a pin from a TCC's PWM output. With the edge
+ * engine the TCC generates the square wave itself, so the timer only
+ * interrupts at the end of each note, and the volume sets the duty cycle.
+ * With the sample based engines each sample sets the duty cycle of a
+ * F_CPU / 4096 (29.3 kHz) carrier, to be filtered by the amplifier or
+ * the speaker.
+ */
+#define TONES_OUTPUT_PWM 1
+
+/** \brief
+ * `TONES_OUTPUT` value. Stream the samples to an I2S amplifier. Only for
+ * `TONES_ENGINE_DMA`. The I2S frame clock paces the DMAC channel.
+ */
+#define TONES_OUTPUT_I2S 2
+
+// The output to use. Define this in the build flags to override.
+#ifndef TONES_OUTPUT
+#define TONES_OUTPUT TONES_OUTPUT_DAC
+#endif
+
+#if TONES_OUTPUT == TONES_OUTPUT_PWM
+// The TCC (0 or 1, which have 24 bit counters), its compare channel, the
+// Arduino pin of its waveform output and the pin's peripheral function
+// (5 for function F, 6 for G). All must be defined for the board, as the
+// pin's row of the data sheet's multiplexing table gives them.
+#if !defined(TONES_PWM_TCC) || !defined(TONES_PWM_CC) || \
+    !defined(TONES_PWM_PIN) || !defined(TONES_PWM_PMUX)
+#error "TONES_OUTPUT_PWM needs TONES_PWM_TCC, TONES_PWM_CC, TONES_PWM_PIN and TONES_PWM_PMUX"
+#endif
+#if TONES_PWM_TCC == 0
+#define PWM_TCC     TCC0
+#define PWM_GCLK_ID TCC0_GCLK_ID
+#elif TONES_PWM_TCC == 1
+#define PWM_TCC     TCC1
+#define PWM_GCLK_ID TCC1_GCLK_ID
+#else
+#error "TONES_PWM_TCC must be 0 or 1"
+#endif
+#elif TONES_OUTPUT == TONES_OUTPUT_I2S
+// The Arduino pins of the I2S serial clock (SCK0), frame sync (FS0) and
+// data out (SDO), all used with peripheral function J
+#if !defined(TONES_I2S_SCK_PIN) || !defined(TONES_I2S_FS_PIN) || \
+    !defined(TONES_I2S_SDO_PIN)
+#error "TONES_OUTPUT_I2S needs TONES_I2S_SCK_PIN, TONES_I2S_FS_PIN and TONES_I2S_SDO_PIN"
+#endif
+// The clock generator feeding I2S clock unit 0, and its frequency. It's
+// divided down to 32 bit clocks (two 16 bit slots) per sample, so it must
+// be a multiple of 32 * TONES_SAMPLE_RATE.
+#ifndef TONES_I2S_GCLK
+#define TONES_I2S_GCLK 1
+#endif
+#ifndef TONES_I2S_GCLK_HZ
+#define TONES_I2S_GCLK_HZ 48000000UL
+#endif
+#elif TONES_OUTPUT != TONES_OUTPUT_DAC
+#error "Unknown TONES_OUTPUT"
+#endif
+
+// Set to 1 to measure the library's CPU use with the DWT cycle counter.
+// The measurements are read using stats(). When 0, no instrumentation code
+// is compiled.
+#ifndef TONES_STATS
+#define TONES_STATS 0
+#endif
+
+#if TONES_STATS
+/** \brief
+ * CPU use measurements returned by `ArduboyTones::stats()`.
+ *
+ * \details
+ * All values cover the time since the measurements were last reset. Cycle
+ * counts are CPU clock cycles, so a total divided by `F_CPU` is seconds.
+ * The totals are 32 bits, so they should be reset at least every half
+ * minute or so while sound is playing.
+ */
+struct TonesStats
+{
+  uint32_t interrupts;          ///< Audio interrupts taken.
+  uint32_t interruptsPerSecond; ///< Audio interrupts per second.
+  uint32_t isrCycles;           ///< Total cycles spent in the audio ISR.
+  uint32_t isrMaxCycles;        ///< Longest single audio ISR.
+  uint32_t transitions;         ///< Notes started, and sequence ends.
+  uint32_t nextToneCycles;      ///< Total cycles spent starting notes.
+  uint32_t nextToneMaxCycles;   ///< Longest single note start.
+  uint32_t dacBusy;             ///< Edges or samples dropped, DAC busy.
+  uint32_t elapsedMs;           ///< Milliseconds measured over.
+};
+#endif
+
+#if TONES_CUE_QUEUE_SIZE > 0
+/** \brief
+ * A cue event, read with `ArduboyTones::readCue()`.
+ */
+struct TonesCue
+{
+  uint16_t id;     ///< The `TONES_CUE()` id, or `TONES_CUE_END`.
+  uint8_t channel; ///< The mixer channel the sequence was playing on.
+};
+#endif
+
+/** \brief
+ * A function that reads part of a streamed tone sequence for
+ * `ArduboyTones::tonesStream()`.
+ *
+ * \param offset The position to read from, in 16 bit words from the start
+ * of the sequence.
+ * \param buffer Where to put the words read.
+ * \param count The number of words wanted.
+ *
+ * \return The number of words read. Fewer than `count` means the end of the
+ * data has been reached.
+ */
+typedef uint16_t (*TonesStreamReader)(uint32_t offset, uint16_t *buffer,
+                                      uint16_t count);
+
+// A tone sequence built in program memory by the compiler, for the
+// tone<...>() template
+template <uint16_t... V>
+struct TonesConstSequence
+{
+  static const uint16_t data[sizeof...(V) + 1];
+};
+
+template <uint16_t... V>
+const uint16_t TonesConstSequence<V...>::data[sizeof...(V) + 1] PROGMEM =
+  { V..., TONES_END };
+
+constexpr bool tonesIsMarker(const uint16_t value)
+{
+  return value == TONES_END || value == TONES_REPEAT;
+}
+
+// Check a sequence at compile time: it must end with TONES_END or
+// TONES_REPEAT following the last duration, with no other marker in place
+// of a frequency. Used by tone<>() and TONES_CHECK_SEQUENCE().
+constexpr bool tonesValidSequence(const uint16_t *seq, uint32_t size,
+                                  uint32_t i = 0)
+{
+  return (i >= size) ? false :
+         tonesIsMarker(seq[i]) ? (i == size - 1) :
+         tonesValidSequence(seq, size, i + 2);
+}
+
+// The sequence tone<>() plays, as an array the compiler can check
+template <uint16_t... V>
+struct TonesPairs
+{
+  static constexpr uint16_t values[sizeof...(V) + 1] = { V..., TONES_END };
+
+  // A marker given as the last frequency ends the sequence itself, and its
+  // duration is ignored
+  static constexpr uint32_t size =
+    (sizeof...(V) >= 2 && tonesIsMarker(values[sizeof...(V) - 2])) ?
+    sizeof...(V) - 1 : sizeof...(V) + 1;
+};
+
+template <uint16_t... V>
+constexpr uint16_t TonesPairs<V...>::values[sizeof...(V) + 1];
+
 
 /** \brief
  * The ArduboyTones class for generating tones by specifying
@@ -80,9 +731,15 @@ class ArduboyTones
    * \param outEn A function which returns a boolean value of `true` if sound
    * should be played or `false` if sound should be muted. This function will
    * be called from the timer interrupt service routine, at the start of each
-   * tone, so it should be as fast as possible.
+   * tone, so it should be as fast as possible. If `NULL`, sound is enabled
+   * until `setOutputEnabled()` is called.
+   *
+   * \param irqPriority The NVIC priority of the audio interrupt, from 0
+   * (highest) to 7 (lowest). Use a lower priority (higher number) if other
+   * peripherals, such as display DMA or USB, are more latency critical.
    */
-  ArduboyTones(bool (*outEn)());
+  ArduboyTones(bool (*outEn)() = NULL,
+               uint8_t irqPriority = TONES_IRQ_PRIORITY);
 
   /** \brief
    * Play a single tone.
@@ -117,22 +774,114 @@ class ArduboyTones
                    uint16_t freq3, uint16_t dur3);
 
   /** \brief
-   * Play a tone sequence from frequency/duration pairs in a PROGMEM array.
+   * Play four or more tones in sequence, up to `MAX_TONES`.
    *
-   * \param tones A pointer to an array of frequency/duration pairs.
-   * The array must be placed in code space using `PROGMEM`.
+   * \param freq1,dur1,... Frequency and duration pairs, as for the other
+   * `tone()` functions.
    *
    * \details
-   * \parblock
-   * See the `tone()` function for details on the frequency and duration values.
-   * A frequency of 0 for any tone means silence (a musical rest).
+   * The number of values is checked when the sketch is compiled: it must be
+   * an even number, and no more than `MAX_TONES` pairs. `MAX_TONES` is 3 by
+   * default, so it must be defined larger in the build flags to use this.
+   * The tones are copied into one of the library's `tone()` buffers, so no
+   * RAM is needed for them after the call.
+   */
+  template <typename... More>
+  static void tone(uint16_t freq1, uint16_t dur1,
+                   uint16_t freq2, uint16_t dur2,
+                   uint16_t freq3, uint16_t dur3,
+                   uint16_t freq4, uint16_t dur4, More... more)
+  {
+    static_assert(sizeof...(More) % 2 == 0,
+                  "tone() needs a duration after every frequency");
+    static_assert(4 + sizeof...(More) / 2 <= MAX_TONES,
+                  "Too many tones for tone(). Define MAX_TONES larger.");
+    const uint16_t words[] = { freq1, dur1, freq2, dur2, freq3, dur3,
+                               freq4, dur4, (uint16_t)more... };
+
+    toneWords(words, sizeof(words) / sizeof(words[0]));
+  }
+
+  /** \brief
+   * Play a sequence of tones that is known when the sketch is compiled,
+   * stored in program memory.
    *
-   * The last element of the array must be `TONES_END` or `TONES_REPEAT`.
+   * \tparam V Frequency and duration pairs, as for `tone()`, which must be
+   * constants.
    *
-   * Example:
+   * \details
+   * The compiler builds the sequence, with its `TONES_END`, in program
+   * memory and it's played with `tones()`, so it uses no RAM and nothing is
+   * copied. Any number of tones can be given. As with `tone()`, the last
+   * frequency can be `TONES_REPEAT`, with a duration that's ignored. A
+   * missing duration, or a marker or high volume 0 Hz rest (which reads as
+   * `TONES_END`) before the last pair, is a compile error.
    *
-   * \code
-   * const uint16_t sound1[] PROGMEM = {
+   * \code{.cpp}
+   * sound.tone<NOTE_C5, 80, NOTE_E5, 80, NOTE_G5, 80, NOTE_C6, 240>();
+   * \endcode
+   */
+  template <uint16_t... V>
+  static void tone()
+  {
+    static_assert(sizeof...(V) != 0 && sizeof...(V) % 2 == 0,
+                  "tone<>() needs frequency and duration pairs");
+    static_assert(tonesValidSequence(TonesPairs<V...>::values,
+                                     TonesPairs<V...>::size),
+                  "Only the last frequency in tone<>() can be TONES_END or "
+                  "TONES_REPEAT");
+
+    tones(TonesConstSequence<V...>::data);
+  }
+
+  /** \brief
+   * Play a single tone at a frequency given to a fraction of a hertz.
+   *
+   * \param freq The frequency of the tone, in 1/16 Hz, from 256 (16 Hz) to
+   * 524272 (32767 Hz). Use `TONES_FINE_HZ()` to convert from hertz, or the
+   * `NOTE_FINE_*` values for exactly tuned notes. 0 is a rest.
+   * \param dur The duration, as for `tone()`.
+   *
+   * \details
+   * With the edge engine the timer period is dithered between two counts
+   * so that the average frequency is exact to a small fraction of a cent,
+   * without any extra interrupts. The sample based engines are exact to
+   * within 1/65536 Hz. Whole hertz tones, and `noteTones()` sequences, are
+   * played the same way.
+   *
+   * The 1/16 Hz unit itself limits how close a frequency can be given. The
+   * rounding error of up to 1/32 Hz is within a cent above about 55 Hz,
+   * but up to 3.4 cents at 16 Hz. `NOTE_FINE_C0` is the worst of the note
+   * values, about 2.5 cents sharp.
+   */
+  static void toneFine(uint32_t freq, uint16_t dur = 0);
+
+  /** \brief
+   * Get the average frequency the engine actually plays for a frequency.
+   *
+   * \param freq The frequency, in 1/16 Hz as for `toneFine()`.
+   *
+   * \return The frequency that is played, in 1/16 Hz, for checking tuning.
+   */
+  static uint32_t tunedFrequency(uint32_t freq);
+
+  /** \brief
+   * Play a tone sequence from frequency/duration pairs in a PROGMEM array.
+   *
+   * \param tones A pointer to an array of frequency/duration pairs.
+   * The array must be placed in code space using `PROGMEM`.
+   *
+   * \details
+   * \parblock
+   * See the `tone()` function for details on the frequency and duration values.
+   * A frequency of 0 for any tone means silence (a musical rest).
+   *
+   * The last element of the array must be `TONES_END` or `TONES_REPEAT`.
+   *
+   * Example:
+   *
+   * \code
+   * const uint16_t sound1[] PROGMEM = {
    *   220,1000, 0,250, 440,500, 880,2000,
    *   TONES_END
    * };
@@ -142,6 +891,86 @@ class ArduboyTones
    */
   static void tones(const uint16_t *tones);
 
+  /** \brief
+   * Play a tone sequence from a PROGMEM array on a mixer channel.
+   *
+   * \param tones A pointer to an array of frequency/duration pairs.
+   * The array must be placed in code space using `PROGMEM`.
+   * \param channel The channel to play the sequence on, from 0 to
+   * `TONES_CHANNELS - 1`.
+   *
+   * \details
+   * Each channel plays its own sequence independently of the others, so for
+   * example music can play on one channel while sound effects are started on
+   * another. The channels are summed into the DAC output.
+   * `tone()` and the other functions without a channel use channel 0.
+   *
+   * \see tones()
+   */
+  static void tones(const uint16_t *tones, uint8_t channel);
+
+  /** \brief
+   * Play a tone sequence from a PROGMEM array on a channel chosen by
+   * priority.
+   *
+   * \param tones A pointer to an array of frequency/duration pairs.
+   * The array must be placed in code space using `PROGMEM`.
+   * \param priority The priority of the sequence, from 0 (lowest) to 255.
+   * \param channelMask A bit mask of the channels which may be used, bit 0
+   * for channel 0 and so on. The default allows any channel.
+   *
+   * \return The channel the sequence is playing on, or -1 if all allowed
+   * channels are playing sequences of a higher priority.
+   *
+   * \details
+   * \parblock
+   * A channel that isn't playing is used if there is one. Otherwise the
+   * sequence replaces the one with the lowest priority, if that isn't higher
+   * than its own. Of channels with equal priority, the one with the least
+   * time left to play is replaced, then the one started longest ago. So a
+   * burst of low priority effects can't cut off an important one, and the
+   * cost of each call is bounded by the number of channels and the length
+   * of the sequence.
+   *
+   * Sequences started by other functions, such as `tone()` and `tones()`,
+   * have priority 0 and an unknown length. To keep music from being
+   * replaced, leave its channel out of the mask.
+   * \endparblock
+   *
+   * \see tones(const uint16_t*, uint8_t)
+   */
+  static int8_t tonesScheduled(const uint16_t *tones, uint8_t priority,
+                               uint8_t channelMask = TONES_ALL_CHANNELS);
+
+  /** \brief
+   * Queue a PROGMEM tone sequence to follow the one currently playing.
+   *
+   * \param tones A pointer to an array of frequency/duration pairs.
+   * The array must be placed in code space using `PROGMEM`.
+   *
+   * \details
+   * When the current sequence reaches its `TONES_END` or `TONES_REPEAT`
+   * marker, the queued sequence starts immediately, without stopping the
+   * timer, so there's no gap between them. A repeating sequence will
+   * therefore play to the end of its current repetition and then switch. If
+   * nothing is playing, the sequence starts right away. Only one sequence
+   * can be queued. Calling this again replaces it, and starting any other
+   * sequence on the channel cancels it.
+   */
+  static void tonesNext(const uint16_t *tones);
+
+  /** \brief
+   * Queue a PROGMEM tone sequence to follow the one playing on a mixer
+   * channel.
+   *
+   * \param tones A pointer to an array of frequency/duration pairs.
+   * The array must be placed in code space using `PROGMEM`.
+   * \param channel The channel, from 0 to `TONES_CHANNELS - 1`.
+   *
+   * \see tonesNext()
+   */
+  static void tonesNext(const uint16_t *tones, uint8_t channel);
+
   /** \brief
    * Play a tone sequence from frequency/duration pairs in an array in RAM.
    *
@@ -174,48 +1003,653 @@ class ArduboyTones
    */
   static void tonesInRAM(uint16_t *tones);
 
+  /** \brief
+   * Play a tone sequence from note index/duration pairs in a PROGMEM array.
+   *
+   * \param notes A pointer to an array of note index/duration pairs.
+   * The array must be placed in code space using `PROGMEM`.
+   *
+   * \details
+   * \parblock
+   * This is the same as `tones()` except that each tone is specified by a
+   * `NOTE_INDEX_*` value instead of a frequency. The timer or phase step
+   * values for each note are calculated at compile time, so starting a note
+   * takes a table lookup instead of divides. `NOTE_INDEX_REST` is a rest and
+   * `TONE_HIGH_VOLUME` can be added for high volume.
+   *
+   * The last element of the array must be `TONES_END` or `TONES_REPEAT`.
+   *
+   * Example:
+   *
+   * \code
+   * const uint16_t song[] PROGMEM = {
+   *   NOTE_INDEX_A3,1000, NOTE_INDEX_REST,250, NOTE_INDEX_A4,500,
+   *   TONES_END
+   * };
+   * \endcode
+   *
+   * \endparblock
+   */
+  static void noteTones(const uint16_t *notes);
+
+  /** \brief
+   * Play a note index sequence from a PROGMEM array on a mixer channel.
+   *
+   * \param notes A pointer to an array of note index/duration pairs.
+   * The array must be placed in code space using `PROGMEM`.
+   * \param channel The channel to play the sequence on, from 0 to
+   * `TONES_CHANNELS - 1`.
+   *
+   * \see noteTones() tones(const uint16_t *, uint8_t)
+   */
+  static void noteTones(const uint16_t *notes, uint8_t channel);
+
+  /** \brief
+   * Play a tone sequence from a packed PROGMEM array.
+   *
+   * \param song A pointer to a packed sequence.
+   * The array must be placed in code space using `PROGMEM`.
+   *
+   * \details
+   * \parblock
+   * A packed sequence uses 2 bytes per event instead of the 4 used by
+   * `tones()`, and runs of the same event, such as rests, can be stored in a
+   * single event. It's decoded as it plays, so it's never unpacked into RAM.
+   *
+   * The first byte is the number of entries in the song's tempo table, from 1
+   * to 16, followed by the entries themselves, each given by
+   * `TONES_PACKED_DURATION()`. The events follow, each given by
+   * `TONES_PACKED_NOTE()` or `TONES_PACKED_RUN()` with a `NOTE_INDEX_*`
+   * value, optionally plus `TONES_PACKED_HIGH_VOLUME`, and the number of a
+   * tempo table entry. The last element must be `TONES_PACKED_END` or
+   * `TONES_PACKED_REPEAT`.
+   *
+   * Example:
+   *
+   * \code
+   * const uint8_t song[] PROGMEM = {
+   *   2, TONES_PACKED_DURATION(250), TONES_PACKED_DURATION(500),
+   *   TONES_PACKED_NOTE(NOTE_INDEX_C4, 0),
+   *   TONES_PACKED_NOTE(NOTE_INDEX_E4 + TONES_PACKED_HIGH_VOLUME, 1),
+   *   TONES_PACKED_RUN(NOTE_INDEX_REST, 1, 4),
+   *   TONES_PACKED_END
+   * };
+   * \endcode
+   *
+   * \endparblock
+   */
+  static void tonesPacked(const uint8_t *song);
+
+  /** \brief
+   * Play a packed tone sequence from a PROGMEM array on a mixer channel.
+   *
+   * \param song A pointer to a packed sequence.
+   * The array must be placed in code space using `PROGMEM`.
+   * \param channel The channel to play the sequence on, from 0 to
+   * `TONES_CHANNELS - 1`.
+   *
+   * \see tonesPacked() tones(const uint16_t *, uint8_t)
+   */
+  static void tonesPacked(const uint8_t *song, uint8_t channel);
+
+  /** \brief
+   * Play a song made of patterns, given by an order list for each channel.
+   *
+   * \param patterns An array of pointers to the patterns, each a tone
+   * sequence in program memory in the same format used by `tones()`. The
+   * array itself must stay in place while it's in use.
+   * \param order The order lists, in program memory, one after the other.
+   * \param channels The number of order lists, and channels to play them
+   * on.
+   * \param firstChannel The channel the first order list plays on. The
+   * others play on the channels following it.
+   *
+   * \details
+   * \parblock
+   * Each order list is a list of pattern numbers, from 0 to 252, played one
+   * after the other, ending with `TONES_ORDER_END`, `TONES_ORDER_REPEAT` or
+   * `TONES_ORDER_LOOP()`. A pattern can be used any number of times, by any
+   * channel, so repeated bars are only stored once. The marker at the end
+   * of a pattern is where the next one starts. The song is played straight
+   * from program memory, with only the position in the order list and in
+   * the pattern held in RAM.
+   *
+   * All the channels are started together, so they stay in time with each
+   * other.
+   *
+   * Example:
+   *
+   * \code
+   * const uint16_t bass[] PROGMEM = { 110,500, 0,500, TONES_END };
+   * const uint16_t riff[] PROGMEM = { 440,250, 660,250, 880,500, TONES_END };
+   * const uint16_t * const patterns[] = { bass, riff };
+   *
+   * const uint8_t order[] PROGMEM = {
+   *   0, 0, 0, 0, TONES_ORDER_REPEAT, // channel 0
+   *   1, 1, TONES_ORDER_END           // channel 1
+   * };
+   *
+   * sound.tonesPatterns(patterns, order, 2);
+   * \endcode
+   *
+   * \endparblock
+   */
+  static void tonesPatterns(const uint16_t * const *patterns,
+                            const uint8_t *order, uint8_t channels = 1,
+                            uint8_t firstChannel = 0);
+
+  /** \brief
+   * Play a song made of patterns in the `noteTones()` format.
+   *
+   * \param patterns An array of pointers to the patterns, each a sequence
+   * of note index/duration pairs in program memory.
+   * \param order The order lists, in program memory, one after the other.
+   * \param channels The number of order lists, and channels to play them
+   * on.
+   * \param firstChannel The channel the first order list plays on.
+   *
+   * \see tonesPatterns() noteTones()
+   */
+  static void notePatterns(const uint16_t * const *patterns,
+                           const uint8_t *order, uint8_t channels = 1,
+                           uint8_t firstChannel = 0);
+
+  /** \brief
+   * Play a tone sequence from an array in RAM on a mixer channel.
+   *
+   * \param tones A pointer to an array of frequency/duration pairs.
+   * The array must be located in RAM.
+   * \param channel The channel to play the sequence on, from 0 to
+   * `TONES_CHANNELS - 1`.
+   *
+   * \see tonesInRAM() tones(const uint16_t *, uint8_t)
+   */
+  static void tonesInRAM(uint16_t *tones, uint8_t channel);
+
+#if TONES_QUEUE_SIZE > 0
+  /** \brief
+   * Add a tone to the end of the streaming queue.
+   *
+   * \param freq The frequency of the tone, in hertz.
+   * \param dur The duration to play the tone for, in 1024ths of a second.
+   *
+   * \return `true` if the tone was added, or `false` if the queue is full.
+   *
+   * \details
+   * \parblock
+   * The queue is a ring buffer of `TONES_QUEUE_SIZE` tones which plays on
+   * channel `TONES_QUEUE_CHANNEL`. Tones can be added while the queue is
+   * playing without stopping or restarting playback, so procedurally
+   * generated audio plays without gaps as long as the queue is kept from
+   * running empty. Use `freeSlots()` to find how many more tones can be
+   * added.
+   *
+   * If the queue runs empty, playback of it stops and is started again by
+   * the next call to `enqueue()`. Calling `enqueue()` while a different
+   * sequence is playing on the queue's channel replaces that sequence.
+   * `noTone()` discards any tones still in the queue.
+   *
+   * Only one part of a program (for example the main loop) should add tones
+   * to the queue.
+   * \endparblock
+   */
+  static bool enqueue(uint16_t freq, uint16_t dur);
+
+  /** \brief
+   * Get the number of tones that can be added to the streaming queue.
+   *
+   * \return The number of tones that `enqueue()` can add before the queue is
+   * full.
+   */
+  static uint8_t freeSlots();
+#endif
+
+  /** \brief
+   * Play a tone sequence streamed from external storage, such as QSPI
+   * flash or an SD card.
+   *
+   * \param reader A function that reads the sequence from storage.
+   * \param buffer A buffer in RAM, used to prefetch the sequence.
+   * \param size The number of 16 bit words in the buffer. A multiple of 4;
+   * any remainder is unused.
+   * \param channel The channel to play the sequence on, from 0 to
+   * `TONES_CHANNELS - 1`.
+   *
+   * \details
+   * \parblock
+   * The sequence has the same layout as a `tones()` array, with each
+   * frequency and duration stored as a 16 bit little endian word, so long
+   * music can be kept off chip. It can end with `TONES_END` or
+   * `TONES_REPEAT`, or just at the end of the data.
+   *
+   * The buffer is split into two halves. The audio interrupt plays from one
+   * while the other is refilled by `streamFill()`, which must be called
+   * regularly, such as once per frame. `reader` is only ever called by this
+   * function and `streamFill()`, never from the interrupt, so it can take as
+   * long as the storage needs. A repeat is followed when the data is read,
+   * so looping music has no gap.
+   *
+   * Each half must last longer than the time between calls to
+   * `streamFill()`. A 64 word buffer holds 16 tones in each half. If a half
+   * isn't refilled in time, a short rest is played instead of waiting, and
+   * `streamUnderruns()` counts it.
+   *
+   * Only one sequence can be streamed at a time. Starting another stops the
+   * first.
+   * \endparblock
+   *
+   * \see streamFill() streamUnderruns()
+   */
+  static void tonesStream(TonesStreamReader reader, uint16_t *buffer,
+                          uint16_t size, uint8_t channel = 0);
+
+  /** \brief
+   * Refill the streamed sequence's buffer.
+   *
+   * \details
+   * Reads the next part of the sequence started by `tonesStream()` into
+   * whichever half of the buffer has finished playing. Does nothing if no
+   * half needs refilling or nothing is being streamed. Must not be called
+   * from an interrupt that can interrupt the audio interrupt.
+   *
+   * \see tonesStream()
+   */
+  static void streamFill();
+
+  /** \brief
+   * Get the number of times a streamed sequence ran out of prefetched tones.
+   *
+   * \param reset If `true`, the count is reset to 0 after being read.
+   *
+   * \return The number of short rests played because `streamFill()` wasn't
+   * called soon enough, since the count was last reset.
+   */
+  static uint32_t streamUnderruns(bool reset = false);
+
   /** \brief
    * Stop playing the tone or sequence.
    *
    * \details
    * If a tone or sequence is playing, it will stop. If nothing
-   * is playing, this function will do nothing.
+   * is playing, this function will do nothing. All channels are stopped.
+   *
+   * The stop is handed to the ISR, and heard at the next audio interrupt
+   * (after the buffer half already rendered with the DMA engine).
    */
   static void noTone();
 
   /** \brief
-   * Originally intended to set the volume to always normal, always high, or tone controlled.
-   * For dotMG, this method has no effect as volume will always be normal.
+   * Stop playing the tone or sequence on one mixer channel.
+   *
+   * \param channel The channel to stop, from 0 to `TONES_CHANNELS - 1`.
+   * Other channels continue playing.
+   */
+  static void noTone(uint8_t channel);
+
+  /** \brief
+   * Enable or mute sound directly, instead of using a callback function.
+   *
+   * \param enabled `true` to enable sound or `false` to mute it.
+   *
+   * \details
+   * \parblock
+   * Once this has been called, the function given to the constructor is no
+   * longer used. The interrupt service routine just reads the flag set here,
+   * so the sketch should call this whenever its mute state changes, for
+   * example after `arduboy.audio.on()` or `arduboy.audio.off()`.
+   *
+   * While muted, nothing is played at all and the timer is stopped, so muted
+   * sound takes no CPU time. Muting stops what's playing, starting a tone or
+   * sequence does nothing, and `playing()` returns `false`. Tones passed to
+   * `enqueue()` are discarded.
+   * \endparblock
+   */
+  static void setOutputEnabled(bool enabled);
+
+  /** \brief
+   * Set the volume of channel 0.
+   *
+   * \param level The volume, from 0 (silent) to `TONES_VOLUME_MAX` (the
+   * default). Each level is 3 dB lower than the one above it.
+   *
+   * \details
+   * The volume scales the normal and high volume levels of tones, and takes
+   * effect immediately. It's applied when each tone starts, so it adds no
+   * work per edge or sample.
+   *
+   * \see setVolume(uint8_t, uint8_t)
+   */
+  static void setVolume(uint8_t level);
+
+  /** \brief
+   * Set the volume of a mixer channel.
+   *
+   * \param channel The channel, from 0 to `TONES_CHANNELS - 1`.
+   * \param level The volume, from 0 (silent) to `TONES_VOLUME_MAX`.
+   *
+   * \see setVolume(uint8_t)
+   */
+  static void setVolume(uint8_t channel, uint8_t level);
+
+  /** \brief
+   * Set the master volume, applied to all channels.
+   *
+   * \param level The volume, from 0 (silent) to `TONES_VOLUME_MAX` (the
+   * default). Each level is 3 dB lower than the one above it.
+   *
+   * \details
+   * The master volume adds to each channel's own volume, in 3 dB steps, so a
+   * game can offer a volume setting without changing the volumes its sound
+   * effects were balanced with. It takes effect immediately. The output
+   * levels for every combination are in a table computed at compile time,
+   * so changing the volume is a table lookup per channel.
+   *
+   * \see setVolume(uint8_t, uint8_t) volumeMode()
+   */
+  static void setMasterVolume(uint8_t level);
+
+#if TONES_WAVETABLES
+  /** \brief
+   * Set the waveform played on channel 0.
+   *
+   * \param waveform One of the `TONES_WAVE_` values, such as
+   * `TONES_WAVE_TRIANGLE`.
+   *
+   * \details
+   * Only available with a sample based engine and `TONES_WAVETABLES`
+   * defined as 1. The wavetables have 256 entries indexed by the top bits of
+   * the channel's phase accumulator, so each sample costs one table read and
+   * one multiply. The band limited square and sawtooth waves have a table
+   * for each octave range, chosen when a tone starts so that no harmonics
+   * are above half the sample rate.
+   *
+   * \see setWaveform(uint8_t, uint8_t)
+   */
+  static void setWaveform(uint8_t waveform);
+
+  /** \brief
+   * Set the waveform played on a mixer channel.
+   *
+   * \param channel The channel, from 0 to `TONES_CHANNELS - 1`.
+   * \param waveform One of the `TONES_WAVE_` values.
+   *
+   * \see setWaveform(uint8_t)
+   */
+  static void setWaveform(uint8_t channel, uint8_t waveform);
+#endif
+
+#if TONES_PCM
+  /** \brief
+   * Play a digitized sound, such as a voice clip or an explosion, along
+   * with whatever tones are playing.
+   *
+   * \param data The sample data, in program memory.
+   * \param length The number of samples. With `TONES_PCM_ADPCM` that's two
+   * for each byte.
+   * \param rate The sample rate of the data, in hertz.
+   * \param format `TONES_PCM_8BIT` or `TONES_PCM_ADPCM`.
+   *
+   * \details
+   * \parblock
+   * Only available with a sample based engine and `TONES_PCM` defined as 1.
+   * The data is decoded 32 samples at a time into a small buffer, which the
+   * audio interrupt resamples to `TONES_SAMPLE_RATE` with a 16.16 fixed
+   * point step and mixes with the tone channels. There's no interpolation,
+   * so data at lower rates sounds a little rougher, but costs no more to
+   * play.
+   *
+   * Only one sample plays at a time. Starting another replaces it. Nothing
+   * is played while sound is muted.
+   * \endparblock
+   *
+   * \see stopSample() samplePlaying() setSampleVolume()
+   */
+  static void playSample(const uint8_t *data, uint32_t length, uint16_t rate,
+                         uint8_t format = TONES_PCM_8BIT);
+
+  /** \brief
+   * Stop the sample started by `playSample()`. `noTone()` stops it too.
+   */
+  static void stopSample();
+
+  /** \brief
+   * Check if a sample started by `playSample()` is playing.
+   *
+   * \return `true` if the sample hasn't reached its end.
+   */
+  static bool samplePlaying();
+
+  /** \brief
+   * Set the volume of samples played by `playSample()`.
+   *
+   * \param level The volume, from 0 (silent) to `TONES_VOLUME_MAX` (the
+   * default), in the same 3 dB steps as `setVolume()`. The master volume
+   * applies too. At full volume a sample's peaks reach the level of a high
+   * volume tone.
+   */
+  static void setSampleVolume(uint8_t level);
+#endif
+
+  /** \brief
+   * Set the volume to always normal, always high, or tone controlled.
    *
    * \param mode
    * \parblock
-   * Originally, this would be one of the following values:
+   * One of the following values should be used:
    *
    * - `VOLUME_IN_TONE` The volume of each tone will be specified in the tone
-   *    itself.
+   *    itself, using `TONE_HIGH_VOLUME` (the default).
    * - `VOLUME_ALWAYS_NORMAL` All tones will play at the normal volume level.
    * - `VOLUME_ALWAYS_HIGH` All tones will play at the high volume level.
-   *
-   * However, as noted in the method description, volume will always be normal for dotMG,
-   * regardless of calls to this method.
    * \endparblock
+   *
+   * \details
+   * High volume drives the DAC to full scale and normal volume to half of
+   * it, 6 dB lower, matching the original Arduboy where high volume drove
+   * the speaker from both pins. The mode takes effect from the next tone.
+   *
+   * \see setMasterVolume()
    */
   static void volumeMode(uint8_t mode);
 
   /** \brief
    * Check if a tone or tone sequence is playing.
    *
-   * \return boolean `true` if playing (even if sound is muted).
+   * \return boolean `true` if playing on any channel (even if sound is
+   * muted). A sequence that has been started but not yet picked up by the
+   * ISR counts as playing.
    */
   static bool playing();
 
-private:
-  // Get the next value in the sequence
-  static uint16_t getNext();
+  /** \brief
+   * Check if a tone or tone sequence is playing on a mixer channel.
+   *
+   * \param channel The channel to check, from 0 to `TONES_CHANNELS - 1`.
+   *
+   * \return boolean `true` if playing (even if sound is muted).
+   */
+  static bool playing(uint8_t channel);
+
+  /** \brief
+   * Get the number of waveform edges dropped because the DAC was busy.
+   *
+   * \param reset If `true`, the count is reset to 0 after being read.
+   *
+   * \return The number of edges not written since the count was last reset.
+   *
+   * \details
+   * The interrupt service routine never waits for the DAC. If it's still
+   * busy with the previous write, the edge is dropped, which only lengthens
+   * one half cycle of the tone. This count indicates how often that happens.
+   */
+  static uint32_t droppedEdges(bool reset = false);
+
+  /** \brief
+   * Set the table of sound effects played by `trigger()`.
+   *
+   * \param effects An array of pointers to tone sequences in program
+   * memory, in the same format used by `tones()`. The array itself must
+   * stay in place while it's in use.
+   * \param count The number of entries in the array.
+   */
+  static void setEffects(const uint16_t * const *effects, uint8_t count);
+
+  /** \brief
+   * Start a sound effect from the table set by `setEffects()`, with as
+   * little work in the caller as possible.
+   *
+   * \param effect The index of the effect in the table.
+   * \param pitch Scales the frequencies of the effect. `TONES_PITCH_NORMAL`
+   * plays it as written. The scale is 8.8 fixed point, so 512 plays it an
+   * octave higher and 128 an octave lower.
+   *
+   * \details
+   * \parblock
+   * The effect is posted to the audio interrupt service routine as a single
+   * command word and this returns without stopping the timer or waiting for
+   * anything. The effect replaces whatever is playing on
+   * `TONES_EFFECT_CHANNEL` at the next audio interrupt. With the DMA engine
+   * that's the next buffer half. Only if nothing is playing is the effect
+   * started directly, the same way `tones()` would start it.
+   *
+   * If this is called again before the interrupt, only the latest effect is
+   * played.
+   * \endparblock
+   */
+  static void trigger(uint8_t effect, uint16_t pitch = TONES_PITCH_NORMAL);
+
+  /** \brief
+   * Get the time since the tone or sequence playing on channel 0 started.
+   *
+   * \return The time, in the same units as durations.
+   *
+   * \details
+   * \parblock
+   * The time is counted by the audio timer as the sequence plays, including
+   * repeats and chained sequences, and each tone's end follows on exactly
+   * from the end of the one before. So it never drifts from the music, and
+   * can be used as a tempo clock to keep game events on the beat. For
+   * example, with a beat lasting 512:
+   *
+   * \code{.cpp}
+   * uint32_t beat = sound.sequenceTime() / 512;
+   * \endcode
+   *
+   * The time is reset when a new tone or sequence is started and stops
+   * advancing when the sequence ends.
+   *
+   * With the edge engine the time advances at each timer interrupt, so its
+   * resolution is one half cycle of the tone, or the length of a rest with
+   * `TONES_POWER_SAVE`. With the DMA engine it includes the samples already
+   * rendered but not yet played.
+   * \endparblock
+   *
+   * \see sequenceTime(uint8_t)
+   */
+  static uint32_t sequenceTime();
+
+  /** \brief
+   * Get the time since the tone or sequence playing on a mixer channel
+   * started.
+   *
+   * \param channel The channel, from 0 to `TONES_CHANNELS - 1`.
+   *
+   * \return The time, in the same units as durations.
+   *
+   * \see sequenceTime()
+   */
+  static uint32_t sequenceTime(uint8_t channel);
+
+#if TONES_CUE_QUEUE_SIZE > 0
+  /** \brief
+   * Get the next cue event, if there is one.
+   *
+   * \param cue Set to the event.
+   *
+   * \return `true` if an event was read, `false` if the queue is empty.
+   *
+   * \details
+   * Events are queued by the ISR as sequences reach their `TONES_CUE()`
+   * markers, and as they end. Up to `TONES_CUE_QUEUE_SIZE` events are held.
+   * Events that arrive while the queue is full are dropped. With the DMA
+   * engine an event is queued as its part of the sequence is rendered, up
+   * to half the buffer before it's heard.
+   */
+  static bool readCue(TonesCue &cue);
+
+#if TONES_CUE_PENDSV
+  /** \brief
+   * Set a function to call when a cue event is queued.
+   *
+   * \param callback The function, or `NULL` for none. It's called from the
+   * PendSV exception at the lowest interrupt priority, after the audio
+   * interrupt has returned, and should read the events with `readCue()`.
+   * Only available with `TONES_CUE_PENDSV` defined as 1.
+   */
+  static void setCueCallback(void (*callback)());
+#endif
+#endif
+
+#if TONES_STATS
+  /** \brief
+   * Get measurements of the CPU time used by the library.
+   *
+   * \param reset If `true`, all measurements are reset after being read,
+   * including the count returned by `droppedEdges()`.
+   *
+   * \return A `TonesStats` struct holding the measurements.
+   *
+   * \details
+   * \parblock
+   * Only available if `TONES_STATS` is defined as 1. The audio interrupt
+   * service routine, and each start of a new note within it or by a
+   * function such as `tone()`, is timed with the DWT cycle counter, which is
+   * enabled by the constructor.
+   *
+   * The share of the CPU used by the interrupt is
+   * `isrCycles / (F_CPU / 1000 * elapsedMs)`.
+   * \endparblock
+   */
+  static TonesStats stats(bool reset = false);
+#endif
+
+#if TONES_TIMER == TONES_TIMER_SHARED
+  /** \brief
+   * Play one sample. Call this at `TONES_SAMPLE_RATE` from the sketch's own
+   * periodic interrupt.
+   *
+   * \details
+   * Only available with `TONES_TIMER` defined as `TONES_TIMER_SHARED`. It
+   * must be called from the interrupt given by `TONES_TICK_IRQ`, which the
+   * library briefly disables while starting and stopping tones. When
+   * nothing is playing it returns straight away. Other work at a lower rate
+   * can share the interrupt by counting ticks:
+   *
+   * \code{.cpp}
+   * void TC4_Handler() {
+   *   ArduboyTones::tick();
+   *   if (++ticks == TONES_SAMPLE_RATE / 1000) { // once a millisecond
+   *     ticks = 0;
+   *     pollButtons();
+   *   }
+   *   TC4->COUNT16.INTFLAG.bit.MC0 = 1;
+   * }
+   * \endcode
+   */
+  static void tick();
+#endif
 
 public:
   // Called from ISR so must be public. Should not be called by a program.
   static void nextTone();
+
+  // Play count frequency/duration words from a tone() buffer. Used by the
+  // tone() template. Should not be called by a program.
+  static void toneWords(const uint16_t *words, uint8_t count);
+
+  // Render samples for the sample based engines. Called from ISR so must be
+  // public. Should not be called by a program.
+  static void fillBuffer(uint16_t *buf, uint16_t count);
 };
 
 #include "ArduboyTonesPitches.h"
@@ -130,9 +130,163 @@
 #define NOTE_AS9 14917
 #define NOTE_B9  15804
 
+// Exact frequencies of the notes above, in 1/16 Hz, for toneFine(). The
+// note indexed tables are generated from these, so noteTones() sequences
+// play in tune even where the whole Hz values above are rounded.
+#define NOTE_FINE_C0     262
+#define NOTE_FINE_CS0    277
+#define NOTE_FINE_D0     294
+#define NOTE_FINE_DS0    311
+#define NOTE_FINE_E0     330
+#define NOTE_FINE_F0     349
+#define NOTE_FINE_FS0    370
+#define NOTE_FINE_G0     392
+#define NOTE_FINE_GS0    415
+#define NOTE_FINE_A0     440
+#define NOTE_FINE_AS0    466
+#define NOTE_FINE_B0     494
+#define NOTE_FINE_C1     523
+#define NOTE_FINE_CS1    554
+#define NOTE_FINE_D1     587
+#define NOTE_FINE_DS1    622
+#define NOTE_FINE_E1     659
+#define NOTE_FINE_F1     698
+#define NOTE_FINE_FS1    740
+#define NOTE_FINE_G1     784
+#define NOTE_FINE_GS1    831
+#define NOTE_FINE_A1     880
+#define NOTE_FINE_AS1    932
+#define NOTE_FINE_B1     988
+#define NOTE_FINE_C2     1047
+#define NOTE_FINE_CS2    1109
+#define NOTE_FINE_D2     1175
+#define NOTE_FINE_DS2    1245
+#define NOTE_FINE_E2     1319
+#define NOTE_FINE_F2     1397
+#define NOTE_FINE_FS2    1480
+#define NOTE_FINE_G2     1568
+#define NOTE_FINE_GS2    1661
+#define NOTE_FINE_A2     1760
+#define NOTE_FINE_AS2    1865
+#define NOTE_FINE_B2     1976
+#define NOTE_FINE_C3     2093
+#define NOTE_FINE_CS3    2217
+#define NOTE_FINE_D3     2349
+#define NOTE_FINE_DS3    2489
+#define NOTE_FINE_E3     2637
+#define NOTE_FINE_F3     2794
+#define NOTE_FINE_FS3    2960
+#define NOTE_FINE_G3     3136
+#define NOTE_FINE_GS3    3322
+#define NOTE_FINE_A3     3520
+#define NOTE_FINE_AS3    3729
+#define NOTE_FINE_B3     3951
+#define NOTE_FINE_C4     4186
+#define NOTE_FINE_CS4    4435
+#define NOTE_FINE_D4     4699
+#define NOTE_FINE_DS4    4978
+#define NOTE_FINE_E4     5274
+#define NOTE_FINE_F4     5588
+#define NOTE_FINE_FS4    5920
+#define NOTE_FINE_G4     6272
+#define NOTE_FINE_GS4    6645
+#define NOTE_FINE_A4     7040
+#define NOTE_FINE_AS4    7459
+#define NOTE_FINE_B4     7902
+#define NOTE_FINE_C5     8372
+#define NOTE_FINE_CS5    8870
+#define NOTE_FINE_D5     9397
+#define NOTE_FINE_DS5    9956
+#define NOTE_FINE_E5     10548
+#define NOTE_FINE_F5     11175
+#define NOTE_FINE_FS5    11840
+#define NOTE_FINE_G5     12544
+#define NOTE_FINE_GS5    13290
+#define NOTE_FINE_A5     14080
+#define NOTE_FINE_AS5    14917
+#define NOTE_FINE_B5     15804
+#define NOTE_FINE_C6     16744
+#define NOTE_FINE_CS6    17740
+#define NOTE_FINE_D6     18795
+#define NOTE_FINE_DS6    19912
+#define NOTE_FINE_E6     21096
+#define NOTE_FINE_F6     22351
+#define NOTE_FINE_FS6    23680
+#define NOTE_FINE_G6     25088
+#define NOTE_FINE_GS6    26580
+#define NOTE_FINE_A6     28160
+#define NOTE_FINE_AS6    29834
+#define NOTE_FINE_B6     31609
+#define NOTE_FINE_C7     33488
+#define NOTE_FINE_CS7    35479
+#define NOTE_FINE_D7     37589
+#define NOTE_FINE_DS7    39824
+#define NOTE_FINE_E7     42192
+#define NOTE_FINE_F7     44701
+#define NOTE_FINE_FS7    47359
+#define NOTE_FINE_G7     50175
+#define NOTE_FINE_GS7    53159
+#define NOTE_FINE_A7     56320
+#define NOTE_FINE_AS7    59669
+#define NOTE_FINE_B7     63217
+#define NOTE_FINE_C8     66976
+#define NOTE_FINE_CS8    70959
+#define NOTE_FINE_D8     75178
+#define NOTE_FINE_DS8    79649
+#define NOTE_FINE_E8     84385
+#define NOTE_FINE_F8     89402
+#define NOTE_FINE_FS8    94719
+#define NOTE_FINE_G8     100351
+#define NOTE_FINE_GS8    106318
+#define NOTE_FINE_A8     112640
+#define NOTE_FINE_AS8    119338
+#define NOTE_FINE_B8     126434
+#define NOTE_FINE_C9     133952
+#define NOTE_FINE_CS9    141918
+#define NOTE_FINE_D9     150356
+#define NOTE_FINE_DS9    159297
+#define NOTE_FINE_E9     168769
+#define NOTE_FINE_F9     178805
+#define NOTE_FINE_FS9    189437
+#define NOTE_FINE_G9     200702
+#define NOTE_FINE_GS9    212636
+#define NOTE_FINE_A9     225280
+#define NOTE_FINE_AS9    238676
+#define NOTE_FINE_B9     252868
+
+// List of all the notes above, in order. Used to generate note indexed
+// tables at compile time.
+#define TONES_NOTE_LIST(X) \
+  X(C0) X(CS0) X(D0) X(DS0) X(E0) X(F0) X(FS0) X(G0) X(GS0) X(A0) X(AS0) X(B0) \
+  X(C1) X(CS1) X(D1) X(DS1) X(E1) X(F1) X(FS1) X(G1) X(GS1) X(A1) X(AS1) X(B1) \
+  X(C2) X(CS2) X(D2) X(DS2) X(E2) X(F2) X(FS2) X(G2) X(GS2) X(A2) X(AS2) X(B2) \
+  X(C3) X(CS3) X(D3) X(DS3) X(E3) X(F3) X(FS3) X(G3) X(GS3) X(A3) X(AS3) X(B3) \
+  X(C4) X(CS4) X(D4) X(DS4) X(E4) X(F4) X(FS4) X(G4) X(GS4) X(A4) X(AS4) X(B4) \
+  X(C5) X(CS5) X(D5) X(DS5) X(E5) X(F5) X(FS5) X(G5) X(GS5) X(A5) X(AS5) X(B5) \
+  X(C6) X(CS6) X(D6) X(DS6) X(E6) X(F6) X(FS6) X(G6) X(GS6) X(A6) X(AS6) X(B6) \
+  X(C7) X(CS7) X(D7) X(DS7) X(E7) X(F7) X(FS7) X(G7) X(GS7) X(A7) X(AS7) X(B7) \
+  X(C8) X(CS8) X(D8) X(DS8) X(E8) X(F8) X(FS8) X(G8) X(GS8) X(A8) X(AS8) X(B8) \
+  X(C9) X(CS9) X(D9) X(DS9) X(E9) X(F9) X(FS9) X(G9) X(GS9) X(A9) X(AS9) X(B9)
+
+#define TONES_NOTE_INDEX_ENUM(n) NOTE_INDEX_##n,
+
+/** \brief
+ * Note indices for use in sequences played by `ArduboyTones::noteTones()`.
+ *
+ * \details
+ * These are `NOTE_INDEX_<letter><optional S for sharp><octave number>`,
+ * numbered from `NOTE_INDEX_C0` (1) to `NOTE_INDEX_B9` (120).
+ * Add `TONE_HIGH_VOLUME` for high volume.
+ */
+enum {
+  NOTE_INDEX_REST = 0,
+  TONES_NOTE_LIST(TONES_NOTE_INDEX_ENUM)
+  NOTE_INDEX_COUNT
+};
+
 #define NOTE_C0H  (NOTE_C0 + TONE_HIGH_VOLUME)
 #define NOTE_CS0H (NOTE_CS0 + TONE_HIGH_VOLUME)
-#define NOTE_D0H  (NOTE_D08 + TONE_HIGH_VOLUME)
+#define NOTE_D0H  (NOTE_D0 + TONE_HIGH_VOLUME)
 #define NOTE_DS0H (NOTE_DS0 + TONE_HIGH_VOLUME)
 #define NOTE_E0H  (NOTE_E0 + TONE_HIGH_VOLUME)
 #define NOTE_F0H  (NOTE_F0 + TONE_HIGH_VOLUME)
@@ -172,7 +326,7 @@
 #define NOTE_DS3H (NOTE_DS3 + TONE_HIGH_VOLUME)
 #define NOTE_E3H  (NOTE_E3 + TONE_HIGH_VOLUME)
 #define NOTE_F3H  (NOTE_F3 + TONE_HIGH_VOLUME)
-#define NOTE_FS3H (NOTE_F3 + TONE_HIGH_VOLUME)
+#define NOTE_FS3H (NOTE_FS3 + TONE_HIGH_VOLUME)
 #define NOTE_G3H  (NOTE_G3 + TONE_HIGH_VOLUME)
 #define NOTE_GS3H (NOTE_GS3 + TONE_HIGH_VOLUME)
 #define NOTE_A3H  (NOTE_A3 + TONE_HIGH_VOLUME)
@@ -0,0 +1,196 @@
+/**
+ * @file ArduboyTonesSong.h
+ * \brief Compile time building and checking of tone sequences.
+ *
+ * \details
+ * Include this after `ArduboyTones.h` to write songs as notes with lengths
+ * and a tempo, instead of as hand calculated arrays. The song is checked and
+ * converted to a `noteTones()` sequence when the sketch is compiled, so a
+ * mistake such as a missing end marker is a compile error, and nothing is
+ * calculated when it plays. Each note is played using the timer values
+ * precomputed for its note index.
+ *
+ * \code
+ * TONES_SONG(theme, 120,
+ *   TONES_NOTE(C4, 1, 4),      // a quarter note
+ *   TONES_NOTE(E4, 3, 8),      // a dotted quarter note
+ *   TONES_NOTE_HIGH(G4, 1, 8), // an eighth note at high volume
+ *   TONES_REST(1, 2),
+ *   TONES_SONG_REPEAT);
+ *
+ * sound.noteTones(theme);
+ * \endcode
+ *
+ * Note lengths are fractions of a whole note, which lasts 4 beats. The
+ * denominator must divide 384, so lengths down to 1/128 notes, and triplets,
+ * can be used. The duration of each note is calculated from where it starts
+ * and ends in the song, so rounding to whole duration units never builds up
+ * over a long song.
+ */
+
+#ifndef ARDUBOY_TONES_SONG_H
+#define ARDUBOY_TONES_SONG_H
+
+#include "ArduboyTones.h"
+
+/** \brief
+ * A note in a `TONES_SONG()`.
+ *
+ * \param note The note name, such as `C4` or `FS5`.
+ * \param num The numerator of the note's length, in whole notes.
+ * \param den The denominator of the note's length. Must divide 384.
+ */
+#define TONES_NOTE(note, num, den) NOTE_INDEX_##note, (num), (den)
+
+/** \brief
+ * A note in a `TONES_SONG()` played at high volume. See `TONES_NOTE()`.
+ */
+#define TONES_NOTE_HIGH(note, num, den) \
+  (NOTE_INDEX_##note + TONE_HIGH_VOLUME), (num), (den)
+
+/** \brief
+ * A rest in a `TONES_SONG()`, with its length as for `TONES_NOTE()`.
+ */
+#define TONES_REST(num, den) NOTE_INDEX_REST, (num), (den)
+
+/** \brief
+ * The end of a `TONES_SONG()`. The song stops.
+ */
+#define TONES_SONG_END 0x10000
+
+/** \brief
+ * The end of a `TONES_SONG()`. The song repeats from the start.
+ */
+#define TONES_SONG_REPEAT 0x10001
+
+/** \brief
+ * Define a song, checked and converted to a `noteTones()` sequence at
+ * compile time.
+ *
+ * \param name The name of the song, which is a pointer that can be passed
+ * to `noteTones()`.
+ * \param bpm The tempo, in quarter note beats per minute.
+ * \param ... The notes and rests, ending with `TONES_SONG_END` or
+ * `TONES_SONG_REPEAT`.
+ */
+#define TONES_SONG(name, bpm, ...) \
+  const uint16_t * const name = \
+    TonesSong::Build<TonesSong::Values<>, (bpm), 0, __VA_ARGS__>::type::data
+
+/** \brief
+ * Check a hand written `tones()` or `noteTones()` array at compile time.
+ *
+ * \param array The array. It must be declared `constexpr` instead of
+ * `const`, which places it in flash the same way, so its values can be read
+ * by the compiler.
+ *
+ * \details
+ * Checks that the array ends with `TONES_END` or `TONES_REPEAT` following
+ * the last duration, and has no other end or repeat marker in place of a
+ * frequency.
+ */
+#define TONES_CHECK_SEQUENCE(array) \
+  static_assert(tonesValidSequence((array), \
+                                   sizeof(array) / sizeof((array)[0])), \
+                #array " must end with TONES_END or TONES_REPEAT after its " \
+                "last duration")
+
+namespace TonesSong {
+
+// Song positions are counted in 384ths of a whole note
+const uint32_t TICKS_PER_WHOLE = 384;
+
+#if TONES_DURATION_MS
+const uint64_t UNITS_PER_SECOND = 1000;
+#else
+const uint64_t UNITS_PER_SECOND = 1024;
+#endif
+
+// A position in the song, in duration units from the start, rounded to the
+// nearest unit. A whole note lasts 4 beats.
+constexpr uint64_t unitsAt(uint32_t bpm, uint64_t ticks)
+{
+  return (ticks * 4 * 60 * UNITS_PER_SECOND * 2 + bpm * TICKS_PER_WHOLE) /
+         (bpm * TICKS_PER_WHOLE * 2);
+}
+
+template <uint32_t X>
+struct False
+{
+  static const bool value = false;
+};
+
+// The sequence built so far, and when complete, the PROGMEM array of it
+template <uint16_t... V>
+struct Values
+{
+  static const uint16_t data[sizeof...(V)];
+};
+
+template <uint16_t... V>
+const uint16_t Values<V...>::data[sizeof...(V)] PROGMEM = { V... };
+
+template <class Out, uint32_t Bpm, uint32_t Pos, uint32_t... In>
+struct Build
+{
+  static_assert(False<Pos>::value,
+                "A song must end with TONES_SONG_END or TONES_SONG_REPEAT");
+};
+
+// Anything other than a complete note, or a marker, at the end
+template <bool Marker, class Out, uint32_t Bpm, uint32_t Pos,
+          uint32_t... In>
+struct Step
+{
+  static_assert(Marker, "Each note or rest needs a note and a length, "
+                        "as given by TONES_NOTE() or TONES_REST()");
+};
+
+template <uint16_t... Out, uint32_t Bpm, uint32_t Pos, uint32_t First,
+          uint32_t... Rest>
+struct Build<Values<Out...>, Bpm, Pos, First, Rest...>
+  : Step<(First == TONES_SONG_END || First == TONES_SONG_REPEAT),
+         Values<Out...>, Bpm, Pos, First, Rest...>
+{
+  static_assert(Pos != 0 || (Bpm >= 1 && Bpm <= 10000),
+                "The tempo must be from 1 to 10000 beats per minute");
+};
+
+template <uint16_t... Out, uint32_t Bpm, uint32_t Pos, uint32_t Marker,
+          uint32_t... Rest>
+struct Step<true, Values<Out...>, Bpm, Pos, Marker, Rest...>
+{
+  static_assert(sizeof...(Rest) == 0,
+                "Nothing can follow TONES_SONG_END or TONES_SONG_REPEAT");
+  static_assert(Pos != 0, "A song must have at least one note or rest");
+
+  typedef Values<Out..., (Marker == TONES_SONG_END) ?
+                         (uint16_t)TONES_END : (uint16_t)TONES_REPEAT> type;
+};
+
+template <uint16_t... Out, uint32_t Bpm, uint32_t Pos, uint32_t Note,
+          uint32_t Num, uint32_t Den, uint32_t... Rest>
+struct Step<false, Values<Out...>, Bpm, Pos, Note, Num, Den, Rest...>
+{
+  static_assert((Note & ~TONE_HIGH_VOLUME) < NOTE_INDEX_COUNT,
+                "Not a note index. Use NOTE_INDEX_* note names.");
+  static_assert(Note != TONES_END && Note != TONES_REPEAT,
+                "A rest or C0 at high volume would be read as an end or "
+                "repeat marker");
+  static_assert(Num != 0 && Den != 0, "A note length can't be 0");
+  static_assert(Den <= TICKS_PER_WHOLE && TICKS_PER_WHOLE % Den == 0,
+                "A note length's denominator must divide 384");
+
+  static const uint32_t End = Pos + Num * (TICKS_PER_WHOLE / Den);
+  static const uint64_t Dur = unitsAt(Bpm, End) - unitsAt(Bpm, Pos);
+
+  static_assert(Dur != 0, "A note is too short to last one duration unit");
+  static_assert(Dur <= 0xFFFF, "A note is too long for one duration value");
+
+  typedef typename Build<Values<Out..., (uint16_t)Note, (uint16_t)Dur>,
+                         Bpm, End, Rest...>::type type;
+};
+
+} // namespace TonesSong
+
+#endif
@@ -0,0 +1,260 @@
+/**
+ * @file ArduboyTonesWaves.h
+ * \brief
+ * Wavetables for the sample based engines of the ArduboyTones library.
+ *
+ * \details
+ * Generated by extras/wavetables.py. Don't edit by hand.
+ */
+
+#ifndef ARDUBOY_TONES_WAVES_H
+#define ARDUBOY_TONES_WAVES_H
+
+#define WAVE_TABLE_SIZE 256
+#define WAVE_BL_LEVELS 6
+
+// Band limited square waves, indexed by the maximum harmonic level
+static const uint8_t waveSquare[6][256] PROGMEM = {
+  {
+    128, 131, 134, 137, 140, 143, 146, 149, 152, 155, 158, 162, 165, 167, 170, 173,
+    176, 179, 182, 185, 188, 190, 193, 196, 198, 201, 203, 206, 208, 211, 213, 215,
+    218, 220, 222, 224, 226, 228, 230, 232, 234, 235, 237, 238, 240, 241, 243, 244,
+    245, 246, 248, 249, 250, 250, 251, 252, 253, 253, 254, 254, 254, 255, 255, 255,
+    255, 255, 255, 255, 254, 254, 254, 253, 253, 252, 251, 250, 250, 249, 248, 246,
+    245, 244, 243, 241, 240, 238, 237, 235, 234, 232, 230, 228, 226, 224, 222, 220,
+    218, 215, 213, 211, 208, 206, 203, 201, 198, 196, 193, 190, 188, 185, 182, 179,
+    176, 173, 170, 167, 165, 162, 158, 155, 152, 149, 146, 143, 140, 137, 134, 131,
+    128, 124, 121, 118, 115, 112, 109, 106, 103, 100,  97,  93,  90,  88,  85,  82,
+     79,  76,  73,  70,  67,  65,  62,  59,  57,  54,  52,  49,  47,  44,  42,  40,
+     37,  35,  33,  31,  29,  27,  25,  23,  21,  20,  18,  17,  15,  14,  12,  11,
+     10,   9,   7,   6,   5,   5,   4,   3,   2,   2,   1,   1,   1,   0,   0,   0,
+      0,   0,   0,   0,   1,   1,   1,   2,   2,   3,   4,   5,   5,   6,   7,   9,
+     10,  11,  12,  14,  15,  17,  18,  20,  21,  23,  25,  27,  29,  31,  33,  35,
+     37,  40,  42,  44,  47,  49,  52,  54,  57,  59,  62,  65,  67,  70,  73,  76,
+     79,  82,  85,  88,  90,  93,  97, 100, 103, 106, 109, 112, 115, 118, 121, 124,
+  },
+  {
+    128, 134, 141, 147, 154, 160, 167, 173, 179, 185, 191, 196, 202, 207, 212, 216,
+    221, 225, 229, 233, 236, 239, 242, 245, 247, 249, 251, 252, 253, 254, 255, 255,
+    255, 255, 255, 254, 253, 252, 251, 250, 249, 247, 246, 244, 242, 241, 239, 237,
+    235, 233, 232, 230, 228, 227, 225, 224, 223, 222, 221, 220, 219, 218, 218, 218,
+    218, 218, 218, 218, 219, 220, 221, 222, 223, 224, 225, 227, 228, 230, 232, 233,
+    235, 237, 239, 241, 242, 244, 246, 247, 249, 250, 251, 252, 253, 254, 255, 255,
+    255, 255, 255, 254, 253, 252, 251, 249, 247, 245, 242, 239, 236, 233, 229, 225,
+    221, 216, 212, 207, 202, 196, 191, 185, 179, 173, 167, 160, 154, 147, 141, 134,
+    128, 121, 114, 108, 101,  95,  88,  82,  76,  70,  64,  59,  53,  48,  43,  39,
+     34,  30,  26,  22,  19,  16,  13,  10,   8,   6,   4,   3,   2,   1,   0,   0,
+      0,   0,   0,   1,   2,   3,   4,   5,   6,   8,   9,  11,  13,  14,  16,  18,
+     20,  22,  23,  25,  27,  28,  30,  31,  32,  33,  34,  35,  36,  37,  37,  37,
+     37,  37,  37,  37,  36,  35,  34,  33,  32,  31,  30,  28,  27,  25,  23,  22,
+     20,  18,  16,  14,  13,  11,   9,   8,   6,   5,   4,   3,   2,   1,   0,   0,
+      0,   0,   0,   1,   2,   3,   4,   6,   8,  10,  13,  16,  19,  22,  26,  30,
+     34,  39,  43,  48,  53,  59,  64,  70,  76,  82,  88,  95, 101, 108, 114, 121,
+  },
+  {
+    128, 141, 154, 167, 180, 191, 202, 212, 222, 230, 237, 243, 247, 251, 253, 255,
+    255, 255, 253, 252, 249, 247, 244, 241, 238, 235, 232, 229, 227, 226, 224, 224,
+    224, 224, 224, 225, 227, 229, 230, 232, 234, 236, 238, 240, 241, 243, 244, 244,
+    244, 244, 244, 243, 242, 240, 239, 237, 235, 234, 232, 231, 229, 228, 227, 227,
+    227, 227, 227, 228, 229, 231, 232, 234, 235, 237, 239, 240, 242, 243, 244, 244,
+    244, 244, 244, 243, 241, 240, 238, 236, 234, 232, 230, 229, 227, 225, 224, 224,
+    224, 224, 224, 226, 227, 229, 232, 235, 238, 241, 244, 247, 249, 252, 253, 255,
+    255, 255, 253, 251, 247, 243, 237, 230, 222, 212, 202, 191, 180, 167, 154, 141,
+    128, 114, 101,  88,  75,  64,  53,  43,  33,  25,  18,  12,   8,   4,   2,   0,
+      0,   0,   2,   3,   6,   8,  11,  14,  17,  20,  23,  26,  28,  29,  31,  31,
+     31,  31,  31,  30,  28,  26,  25,  23,  21,  19,  17,  15,  14,  12,  11,  11,
+     11,  11,  11,  12,  13,  15,  16,  18,  20,  21,  23,  24,  26,  27,  28,  28,
+     28,  28,  28,  27,  26,  24,  23,  21,  20,  18,  16,  15,  13,  12,  11,  11,
+     11,  11,  11,  12,  14,  15,  17,  19,  21,  23,  25,  26,  28,  30,  31,  31,
+     31,  31,  31,  29,  28,  26,  23,  20,  17,  14,  11,   8,   6,   3,   2,   0,
+      0,   0,   2,   4,   8,  12,  18,  25,  33,  43,  53,  64,  75,  88, 101, 114,
+  },
+  {
+    128, 154, 180, 203, 222, 237, 247, 253, 255, 253, 249, 244, 238, 233, 228, 226,
+    225, 226, 228, 231, 235, 238, 241, 243, 243, 243, 241, 239, 236, 233, 231, 230,
+    230, 230, 231, 233, 235, 237, 239, 240, 241, 240, 239, 238, 236, 234, 232, 231,
+    231, 231, 232, 234, 235, 237, 239, 240, 240, 240, 239, 237, 236, 234, 233, 232,
+    231, 232, 233, 234, 236, 237, 239, 240, 240, 240, 239, 237, 235, 234, 232, 231,
+    231, 231, 232, 234, 236, 238, 239, 240, 241, 240, 239, 237, 235, 233, 231, 230,
+    230, 230, 231, 233, 236, 239, 241, 243, 243, 243, 241, 238, 235, 231, 228, 226,
+    225, 226, 228, 233, 238, 244, 249, 253, 255, 253, 247, 237, 222, 203, 180, 154,
+    128, 101,  75,  52,  33,  18,   8,   2,   0,   2,   6,  11,  17,  22,  27,  29,
+     30,  29,  27,  24,  20,  17,  14,  12,  12,  12,  14,  16,  19,  22,  24,  25,
+     25,  25,  24,  22,  20,  18,  16,  15,  14,  15,  16,  17,  19,  21,  23,  24,
+     24,  24,  23,  21,  20,  18,  16,  15,  15,  15,  16,  18,  19,  21,  22,  23,
+     24,  23,  22,  21,  19,  18,  16,  15,  15,  15,  16,  18,  20,  21,  23,  24,
+     24,  24,  23,  21,  19,  17,  16,  15,  14,  15,  16,  18,  20,  22,  24,  25,
+     25,  25,  24,  22,  19,  16,  14,  12,  12,  12,  14,  17,  20,  24,  27,  29,
+     30,  29,  27,  22,  17,  11,   6,   2,   0,   2,   8,  18,  33,  52,  75, 101,
+  },
+  {
+    127, 180, 222, 247, 255, 249, 238, 229, 225, 228, 235, 241, 243, 241, 236, 232,
+    230, 232, 235, 239, 240, 239, 236, 233, 232, 233, 235, 238, 239, 238, 236, 233,
+    233, 233, 236, 238, 238, 238, 236, 234, 233, 234, 236, 237, 238, 237, 236, 234,
+    233, 234, 236, 237, 238, 237, 236, 234, 233, 234, 236, 237, 238, 237, 236, 234,
+    233, 234, 236, 237, 238, 237, 236, 234, 233, 234, 236, 237, 238, 237, 236, 234,
+    233, 234, 236, 237, 238, 237, 236, 234, 233, 234, 236, 238, 238, 238, 236, 233,
+    233, 233, 236, 238, 239, 238, 235, 233, 232, 233, 236, 239, 240, 239, 235, 232,
+    230, 232, 236, 241, 243, 241, 235, 228, 225, 229, 238, 249, 255, 247, 222, 180,
+    128,  75,  33,   8,   0,   6,  17,  26,  30,  27,  20,  14,  12,  14,  19,  23,
+     25,  23,  20,  16,  15,  16,  19,  22,  23,  22,  20,  17,  16,  17,  19,  22,
+     22,  22,  19,  17,  17,  17,  19,  21,  22,  21,  19,  18,  17,  18,  19,  21,
+     22,  21,  19,  18,  17,  18,  19,  21,  22,  21,  19,  18,  17,  18,  19,  21,
+     22,  21,  19,  18,  17,  18,  19,  21,  22,  21,  19,  18,  17,  18,  19,  21,
+     22,  21,  19,  18,  17,  18,  19,  21,  22,  21,  19,  17,  17,  17,  19,  22,
+     22,  22,  19,  17,  16,  17,  20,  22,  23,  22,  19,  16,  15,  16,  20,  23,
+     25,  23,  19,  14,  12,  14,  20,  27,  30,  26,  17,   6,   0,   8,  33,  75,
+  },
+  {
+    127, 222, 255, 238, 225, 235, 243, 236, 230, 235, 240, 236, 232, 235, 239, 236,
+    233, 236, 238, 236, 233, 236, 238, 236, 234, 236, 237, 236, 234, 236, 237, 236,
+    234, 236, 237, 236, 234, 236, 237, 236, 234, 236, 237, 236, 234, 236, 237, 236,
+    234, 236, 237, 236, 235, 236, 237, 236, 235, 236, 237, 236, 235, 236, 237, 236,
+    235, 236, 237, 236, 235, 236, 237, 236, 235, 236, 237, 236, 235, 236, 237, 236,
+    234, 236, 237, 236, 234, 236, 237, 236, 234, 236, 237, 236, 234, 236, 237, 236,
+    234, 236, 237, 236, 234, 236, 237, 236, 234, 236, 238, 236, 233, 236, 238, 236,
+    233, 236, 239, 235, 232, 236, 240, 235, 230, 236, 243, 235, 225, 238, 255, 222,
+    128,  33,   0,  17,  30,  20,  12,  19,  25,  20,  15,  19,  23,  20,  16,  19,
+     22,  19,  17,  19,  22,  19,  17,  19,  21,  19,  18,  19,  21,  19,  18,  19,
+     21,  19,  18,  19,  21,  19,  18,  19,  21,  19,  18,  19,  21,  19,  18,  19,
+     21,  19,  18,  19,  20,  19,  18,  19,  20,  19,  18,  19,  20,  19,  18,  19,
+     20,  19,  18,  19,  20,  19,  18,  19,  20,  19,  18,  19,  20,  19,  18,  19,
+     21,  19,  18,  19,  21,  19,  18,  19,  21,  19,  18,  19,  21,  19,  18,  19,
+     21,  19,  18,  19,  21,  19,  18,  19,  21,  19,  17,  19,  22,  19,  17,  19,
+     22,  19,  16,  20,  23,  19,  15,  20,  25,  19,  12,  20,  30,  17,   0,  33,
+  },
+};
+
+// Band limited sawtooth waves, indexed by the maximum harmonic level
+static const uint8_t waveSaw[6][256] PROGMEM = {
+  {
+    128, 131, 134, 137, 140, 143, 146, 149, 152, 155, 158, 162, 165, 167, 170, 173,
+    176, 179, 182, 185, 188, 190, 193, 196, 198, 201, 203, 206, 208, 211, 213, 215,
+    218, 220, 222, 224, 226, 228, 230, 232, 234, 235, 237, 238, 240, 241, 243, 244,
+    245, 246, 248, 249, 250, 250, 251, 252, 253, 253, 254, 254, 254, 255, 255, 255,
+    255, 255, 255, 255, 254, 254, 254, 253, 253, 252, 251, 250, 250, 249, 248, 246,
+    245, 244, 243, 241, 240, 238, 237, 235, 234, 232, 230, 228, 226, 224, 222, 220,
+    218, 215, 213, 211, 208, 206, 203, 201, 198, 196, 193, 190, 188, 185, 182, 179,
+    176, 173, 170, 167, 165, 162, 158, 155, 152, 149, 146, 143, 140, 137, 134, 131,
+    128, 124, 121, 118, 115, 112, 109, 106, 103, 100,  97,  93,  90,  88,  85,  82,
+     79,  76,  73,  70,  67,  65,  62,  59,  57,  54,  52,  49,  47,  44,  42,  40,
+     37,  35,  33,  31,  29,  27,  25,  23,  21,  20,  18,  17,  15,  14,  12,  11,
+     10,   9,   7,   6,   5,   5,   4,   3,   2,   2,   1,   1,   1,   0,   0,   0,
+      0,   0,   0,   0,   1,   1,   1,   2,   2,   3,   4,   5,   5,   6,   7,   9,
+     10,  11,  12,  14,  15,  17,  18,  20,  21,  23,  25,  27,  29,  31,  33,  35,
+     37,  40,  42,  44,  47,  49,  52,  54,  57,  59,  62,  65,  67,  70,  73,  76,
+     79,  82,  85,  88,  90,  93,  97, 100, 103, 106, 109, 112, 115, 118, 121, 124,
+  },
+  {
+    128, 134, 140, 147, 153, 160, 166, 172, 178, 184, 190, 195, 200, 206, 211, 215,
+    220, 224, 228, 232, 235, 238, 241, 244, 246, 248, 250, 252, 253, 254, 254, 255,
+    255, 255, 254, 254, 253, 252, 251, 249, 248, 246, 244, 242, 239, 237, 234, 232,
+    229, 226, 224, 221, 218, 215, 212, 209, 207, 204, 201, 198, 196, 193, 191, 189,
+    186, 184, 182, 180, 179, 177, 175, 174, 173, 172, 171, 170, 169, 168, 168, 167,
+    167, 166, 166, 166, 166, 166, 166, 166, 166, 166, 166, 166, 166, 166, 167, 167,
+    167, 167, 167, 166, 166, 166, 166, 165, 165, 164, 163, 163, 162, 161, 160, 159,
+    157, 156, 155, 153, 151, 150, 148, 146, 144, 142, 140, 138, 136, 134, 132, 130,
+    128, 125, 123, 121, 119, 117, 115, 113, 111, 109, 107, 105, 104, 102, 100,  99,
+     98,  96,  95,  94,  93,  92,  92,  91,  90,  90,  89,  89,  89,  89,  88,  88,
+     88,  88,  88,  89,  89,  89,  89,  89,  89,  89,  89,  89,  89,  89,  89,  89,
+     88,  88,  87,  87,  86,  85,  84,  83,  82,  81,  80,  78,  76,  75,  73,  71,
+     69,  66,  64,  62,  59,  57,  54,  51,  48,  46,  43,  40,  37,  34,  31,  29,
+     26,  23,  21,  18,  16,  13,  11,   9,   7,   6,   4,   3,   2,   1,   1,   0,
+      0,   0,   1,   1,   2,   3,   5,   7,   9,  11,  14,  17,  20,  23,  27,  31,
+     35,  40,  44,  49,  55,  60,  65,  71,  77,  83,  89,  95, 102, 108, 115, 121,
+  },
+  {
+    128, 141, 154, 167, 179, 191, 202, 212, 221, 229, 236, 242, 247, 250, 253, 255,
+    255, 255, 253, 251, 249, 245, 242, 238, 234, 230, 226, 222, 218, 215, 212, 209,
+    207, 206, 204, 204, 203, 203, 203, 204, 205, 206, 207, 208, 208, 209, 210, 210,
+    210, 210, 210, 209, 208, 207, 205, 203, 201, 199, 197, 194, 192, 190, 188, 185,
+    183, 182, 180, 179, 178, 177, 176, 175, 175, 175, 175, 175, 176, 176, 176, 176,
+    176, 176, 176, 175, 175, 174, 173, 172, 171, 169, 167, 166, 164, 162, 160, 158,
+    156, 154, 152, 151, 149, 148, 147, 146, 145, 145, 144, 144, 144, 144, 144, 144,
+    144, 144, 143, 143, 143, 143, 142, 141, 140, 139, 138, 136, 135, 133, 131, 129,
+    128, 126, 124, 122, 120, 119, 117, 116, 115, 114, 113, 112, 112, 112, 112, 111,
+    111, 111, 111, 111, 111, 111, 111, 110, 110, 109, 108, 107, 106, 104, 103, 101,
+     99,  97,  95,  93,  91,  89,  88,  86,  84,  83,  82,  81,  80,  80,  79,  79,
+     79,  79,  79,  79,  79,  80,  80,  80,  80,  80,  79,  78,  77,  76,  75,  73,
+     72,  70,  67,  65,  63,  61,  58,  56,  54,  52,  50,  48,  47,  46,  45,  45,
+     45,  45,  45,  46,  47,  47,  48,  49,  50,  51,  52,  52,  52,  51,  51,  49,
+     48,  46,  43,  40,  37,  33,  29,  25,  21,  17,  13,  10,   6,   4,   2,   0,
+      0,   0,   2,   5,   8,  13,  19,  26,  34,  43,  53,  64,  76,  88, 101, 114,
+  },
+  {
+    128, 154, 179, 202, 221, 236, 247, 253, 255, 253, 249, 243, 236, 229, 224, 219,
+    217, 216, 216, 218, 221, 223, 226, 227, 228, 227, 225, 223, 220, 216, 213, 210,
+    208, 206, 206, 206, 207, 208, 209, 210, 210, 210, 209, 207, 205, 203, 200, 198,
+    196, 194, 193, 193, 193, 193, 194, 194, 195, 194, 194, 192, 191, 189, 186, 184,
+    182, 181, 180, 179, 179, 179, 179, 179, 179, 179, 179, 178, 176, 175, 173, 171,
+    169, 167, 166, 165, 164, 164, 164, 164, 164, 164, 164, 163, 162, 161, 159, 157,
+    155, 153, 152, 151, 150, 150, 150, 150, 150, 150, 149, 149, 148, 146, 145, 143,
+    141, 140, 138, 137, 136, 135, 135, 135, 135, 135, 135, 134, 133, 132, 131, 129,
+    128, 126, 124, 123, 122, 121, 120, 120, 120, 120, 120, 120, 119, 118, 117, 115,
+    114, 112, 110, 109, 107, 106, 106, 105, 105, 105, 105, 105, 105, 104, 103, 102,
+    100,  98,  96,  94,  93,  92,  91,  91,  91,  91,  91,  91,  91,  90,  89,  88,
+     86,  84,  82,  80,  79,  77,  76,  76,  76,  76,  76,  76,  76,  76,  75,  74,
+     73,  71,  69,  66,  64,  63,  61,  61,  60,  61,  61,  62,  62,  62,  62,  61,
+     59,  57,  55,  52,  50,  48,  46,  45,  45,  45,  46,  47,  48,  49,  49,  49,
+     47,  45,  42,  39,  35,  32,  30,  28,  27,  28,  29,  32,  34,  37,  39,  39,
+     38,  36,  31,  26,  19,  12,   6,   2,   0,   2,   8,  19,  34,  53,  76, 101,
+  },
+  {
+    127, 180, 222, 247, 255, 249, 237, 226, 221, 222, 228, 233, 235, 233, 228, 223,
+    219, 219, 222, 224, 226, 224, 221, 217, 214, 214, 215, 217, 217, 216, 214, 211,
+    208, 207, 208, 209, 210, 209, 207, 204, 202, 201, 201, 202, 202, 202, 200, 197,
+    195, 194, 194, 195, 195, 194, 193, 191, 189, 187, 187, 187, 188, 187, 186, 184,
+    182, 181, 180, 180, 181, 180, 179, 177, 175, 174, 173, 173, 173, 173, 172, 170,
+    168, 167, 166, 166, 166, 166, 165, 163, 162, 160, 159, 159, 159, 159, 158, 157,
+    155, 153, 152, 152, 152, 152, 151, 150, 148, 146, 145, 145, 145, 145, 144, 143,
+    141, 140, 139, 138, 138, 138, 137, 136, 134, 133, 132, 131, 131, 131, 130, 129,
+    127, 126, 125, 124, 124, 124, 123, 122, 121, 119, 118, 117, 117, 117, 116, 115,
+    114, 112, 111, 110, 110, 110, 110, 109, 107, 105, 104, 103, 103, 103, 103, 102,
+    100,  98,  97,  96,  96,  96,  96,  95,  93,  92,  90,  89,  89,  89,  89,  88,
+     87,  85,  83,  82,  82,  82,  82,  81,  80,  78,  76,  75,  74,  75,  75,  74,
+     73,  71,  69,  68,  67,  68,  68,  68,  66,  64,  62,  61,  60,  60,  61,  61,
+     60,  58,  55,  53,  53,  53,  54,  54,  53,  51,  48,  46,  45,  46,  47,  48,
+     47,  44,  41,  39,  38,  38,  40,  41,  41,  38,  34,  31,  29,  31,  33,  36,
+     36,  32,  27,  22,  20,  22,  27,  33,  34,  29,  18,   6,   0,   8,  33,  75,
+  },
+  {
+    128, 222, 255, 238, 223, 231, 239, 232, 225, 229, 233, 228, 223, 225, 228, 225,
+    221, 222, 224, 221, 218, 219, 220, 218, 215, 215, 216, 215, 212, 212, 213, 211,
+    208, 208, 209, 208, 205, 205, 206, 204, 202, 201, 202, 201, 199, 198, 199, 197,
+    195, 195, 195, 194, 192, 191, 192, 191, 188, 188, 188, 187, 185, 184, 185, 184,
+    182, 181, 181, 180, 178, 177, 178, 177, 175, 174, 174, 173, 172, 171, 171, 170,
+    168, 167, 167, 167, 165, 164, 164, 163, 161, 160, 160, 160, 158, 157, 157, 156,
+    155, 153, 153, 153, 151, 150, 150, 149, 148, 147, 146, 146, 144, 143, 143, 143,
+    141, 140, 140, 139, 138, 136, 136, 136, 134, 133, 133, 132, 131, 130, 129, 129,
+    128, 126, 126, 125, 124, 123, 122, 122, 121, 119, 119, 119, 117, 116, 115, 115,
+    114, 112, 112, 112, 111, 109, 109, 108, 107, 106, 105, 105, 104, 102, 102, 102,
+    100,  99,  98,  98,  97,  95,  95,  95,  94,  92,  91,  91,  90,  88,  88,  88,
+     87,  85,  84,  84,  83,  82,  81,  81,  80,  78,  77,  78,  77,  75,  74,  74,
+     73,  71,  70,  71,  70,  68,  67,  67,  67,  64,  63,  64,  63,  61,  60,  60,
+     60,  58,  56,  57,  56,  54,  53,  54,  53,  51,  49,  50,  50,  47,  46,  47,
+     47,  44,  42,  43,  43,  40,  39,  40,  40,  37,  35,  36,  37,  34,  31,  33,
+     34,  30,  27,  30,  32,  27,  22,  26,  30,  23,  16,  24,  32,  17,   0,  33,
+  },
+};
+
+// Triangle wave. Its harmonics fall off quickly, so one table is used
+static const uint8_t waveTriangle[256] PROGMEM = {
+  128, 129, 131, 133, 135, 137, 139, 141, 143, 145, 147, 149, 151, 153, 155, 157,
+  159, 161, 163, 165, 167, 169, 171, 173, 175, 177, 179, 181, 183, 185, 187, 189,
+  191, 193, 195, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+  223, 225, 227, 229, 231, 233, 235, 237, 239, 241, 243, 245, 247, 249, 251, 253,
+  255, 253, 251, 249, 247, 245, 243, 241, 239, 237, 235, 233, 231, 229, 227, 225,
+  223, 221, 219, 217, 215, 213, 211, 209, 207, 205, 203, 201, 199, 197, 195, 193,
+  191, 189, 187, 185, 183, 181, 179, 177, 175, 173, 171, 169, 167, 165, 163, 161,
+  159, 157, 155, 153, 151, 149, 147, 145, 143, 141, 139, 137, 135, 133, 131, 129,
+  128, 126, 124, 122, 120, 118, 116, 114, 112, 110, 108, 106, 104, 102, 100,  98,
+   96,  94,  92,  90,  88,  86,  84,  82,  80,  78,  76,  74,  72,  70,  68,  66,
+   64,  62,  60,  58,  56,  54,  52,  50,  48,  46,  44,  42,  40,  38,  36,  34,
+   32,  30,  28,  26,  24,  22,  20,  18,  16,  14,  12,  10,   8,   6,   4,   2,
+    0,   2,   4,   6,   8,  10,  12,  14,  16,  18,  20,  22,  24,  26,  28,  30,
+   32,  34,  36,  38,  40,  42,  44,  46,  48,  50,  52,  54,  56,  58,  60,  62,
+   64,  66,  68,  70,  72,  74,  76,  78,  80,  82,  84,  86,  88,  90,  92,  94,
+   96,  98, 100, 102, 104, 106, 108, 110, 112, 114, 116, 118, 120, 122, 124, 126,
+};
+
+#endif